@@ -15,6 +15,11 @@
 
 #include "ad_solver.h"
 #include "tools.h"
+#include "prof.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "landscape.h"
+#include "multi.h"
 
 
 #if defined(CELL) && defined(__SPU__)
@@ -69,6 +74,16 @@
 
 #define BIG ((unsigned int) -1 >> 1)
 
+#define ADAPT_MANY_LOC_MIN   4	/* 1/N of the iters of a window are local mins */
+
+#define BLOCK_STAG_ITER      100 /* a block search stops after N iters without improvement */
+
+#define ENDGAME_DEPTH        3	/* max nb of swaps of an endgame search */
+#define ENDGAME_WIDTH        6	/* nb of best swaps explored at each level */
+#define ENDGAME_MAX_VAR      16	/* no endgame search with more conflicting vars */
+
+#define Div_Round_Up(x, y)   (((x) + (y) - 1) / (y))
+
 
 
 /*-------*
@@ -81,6 +96,16 @@ typedef struct
 }Pair;
 
 
+typedef struct
+{
+  int prob_select_loc_min;
+  int freeze_loc_min;
+  int freeze_swap;
+  int reset_limit;
+  int nb_var_to_reset;
+}AdaptParams;			/* the parameters which can be adapted */
+
+
 /*------------------*
  * Global variables *
  *------------------*/
@@ -109,9 +134,61 @@ static int list_j_nb;		/* nb of elements of the list */
 static Pair *list_ij;		/* list of max/min (exhaustive) */
 static int list_ij_nb;		/* nb of elements of the list */
 
-#ifdef LOG_FILE
-static FILE *f_log;		/* log file */
-#endif
+static int *reset_var;		/* vars to reset (AD_RESET_WORST/FROZEN) */
+static int *reset_err;		/* cost of each var (AD_RESET_WORST) */
+
+static AdaptParams adapt_init;	/* initial values of adapted parameters */
+static int adapt_best_cost;	/* best_cost at the beginning of the window */
+static int adapt_nb_local_min;	/* nb_local_min at the beginning of the window */
+static int adapt_nb_reset;	/* nb_reset at the beginning of the window */
+static int adapt_plateau;	/* longest plateau ended in the window */
+
+static int tele_best_cost;	/* best cost of the run (all restarts) */
+
+static int verify_on;		/* true if shadow verification is active */
+static int verify_countdown;	/* nb of iters before the next verification */
+static unsigned verify_rand;	/* own generator (does not perturb Random()) */
+
+static AdObserver *observer;	/* copy of ad.observer (NULL if none) */
+static int observer_countdown;	/* nb of iters before the next on_iteration */
+
+static int tabu_on;		/* true if tabu_window > 0 */
+static unsigned long long config_hash; /* Zobrist hash of ad.sol (if tabu_on) */
+static unsigned long long *tabu_hash; /* recent configurations (direct mapped) */
+static int *tabu_swap;		/* nb_swap when each one was reached */
+static unsigned tabu_mask;	/* size of the table - 1 */
+
+static unsigned long long *sol_set; /* hashes of the solutions found (0=free) */
+static unsigned sol_mask;	/* size of the set - 1 */
+
+static int *block_var;		/* vars of the searched block (NULL=all), see Decompose */
+static int block_nb;		/* nb of vars of the block */
+static char *in_block;		/* in_block[i] true if i is in the block (exhaustive) */
+static int *block_part;		/* blocks of the current round (block k at k * block_len) */
+static int block_len;		/* max nb of vars of a block */
+
+static int multi_on;		/* true if several swaps per iter (multi_swap > 1) */
+static int *var_cost;		/* cost of each var at the last iter (-1 if marked) */
+static Pair *extra_swap;	/* swaps done with max_i/min_j in this iter */
+static int extra_nb;		/* nb of elements of extra_swap */
+static int extra_delta;		/* sum of their cost variations */
+static int *used_cstr;		/* constraints changed by the swaps of this iter */
+static int used_nb;		/* nb of elements of used_cstr */
+
+static int weight_on;		/* true if constraint weighting is active */
+static int *weight_cstr;	/* violated constraints (see Raise_Weights) */
+static int weight_countdown;	/* nb of raises before the next decay */
+
+static int compound_on;		/* true if compound_moves > 0 (and swaps not restricted) */
+
+static int endgame_on;		/* true if endgame_cost > 0 */
+static char *endgame_conf;	/* endgame_conf[i] true if var i has a cost (current node) */
+static Pair endgame_cand[ENDGAME_DEPTH][ENDGAME_WIDTH]; /* swaps explored at each level */
+static int endgame_cost[ENDGAME_DEPTH][ENDGAME_WIDTH]; /* cost after each of them */
+static Pair endgame_path[ENDGAME_DEPTH]; /* swaps from the local min (see Endgame_Search) */
+static int endgame_len;		/* nb of swaps of the path leading to a solution */
+static int endgame_fail_swap;	/* nb_swap at the last failed search (-1 if none) */
+
 
 
 //#define BASE_MARK    ad.nb_iter
@@ -122,6 +199,29 @@ static FILE *f_log;		/* log file */
 
 #define USE_PROB_SELECT_LOC_MIN ((unsigned) ad.prob_select_loc_min <= 100)
 
+#define Nb_Cand              ((block_var) ? block_nb : ad.size)
+#define Cand(k)              ((block_var) ? block_var[k] : (k))
+
+#define Observed             __builtin_expect(observer != NULL, 0)
+#define Notify(hook, value)  (observer->hook != NULL && (*observer->hook)(&ad, value, observer->data))
+
+				/* hash of the configuration after swapping i and j */
+#define Move_Hash(i, j)							\
+  (config_hash ^ Zobrist(i, ad.sol[i]) ^ Zobrist(j, ad.sol[j]) ^	\
+   Zobrist(i, ad.sol[j]) ^ Zobrist(j, ad.sol[i]))
+
+#define Tabu_Seen(h)							\
+  (tabu_hash[(unsigned) (h) & tabu_mask] == (h) &&			\
+   ad.nb_swap - tabu_swap[(unsigned) (h) & tabu_mask] < ad.tabu_window)
+
+#define Tabu_Record(h)							\
+  do									\
+    {									\
+      tabu_hash[(unsigned) (h) & tabu_mask] = (h);			\
+      tabu_swap[(unsigned) (h) & tabu_mask] = ad.nb_swap;		\
+    }									\
+  while(0)
+
 
 
 
@@ -143,6 +243,26 @@ static void Show_Debug_Info(void);
 
 
 
+/*
+ *  ZOBRIST
+ *
+ *  Returns the random key of value v for variable i. The key is computed
+ *  (splitmix64 finalizer) so any range of values can be used and all
+ *  processes share the same keys.
+ */
+static inline unsigned long long
+Zobrist(int i, int v)
+{
+  unsigned long long z = ((unsigned long long) i << 32 | (unsigned) v) + 0x9E3779B97F4A7C15ULL;
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+
+
+
 #if defined(DEBUG) && (DEBUG&1)
 /*
  *  ERROR_ALL_MARKED
@@ -171,25 +291,30 @@ Error_All_Marked()
 static void
 Select_Var_High_Cost(void)
 {
-  int i;
+  int i, k, n = Nb_Cand;
   int x, max;
 
   list_i_nb = 0;
   max = 0;
   nb_var_marked = 0;
 
-  for(i = 0; i < ad.size; i++)
+  for(k = 0; k < n; k++)
     {
+      i = Cand(k);
       if (Marked(i))
 	{
 #if defined(DEBUG) && (DEBUG&1)
 	  err_var[i] = Cost_On_Variable(i);
 #endif
+	  if (multi_on)
+	    var_cost[i] = -1;
 	  nb_var_marked++;
 	  continue;
 	}
 
-      x = Cost_On_Variable(i);
+      x = Prof_Call(PROF_COST_ON_VAR, Cost_On_Variable(i));
+      if (multi_on)
+	var_cost[i] = x;
 #if defined(DEBUG) && (DEBUG&1)
       err_var[i] = x;
 #endif
@@ -228,16 +353,17 @@ Select_Var_High_Cost(void)
 static void
 Select_Var_Min_Conflict(void)
 {
-  int j;
+  int j, k, n = Nb_Cand;
   int x;
 
  a:
   list_j_nb = 0;
   new_cost = ad.total_cost;
 
-  for(j = 0; j < ad.size; j++)
+  for(k = 0; k < n; k++)
     {
-      x = Cost_If_Swap(ad.total_cost, j, max_i);
+      j = Cand(k);
+      x = Prof_Call(PROF_COST_IF_SWAP, Cost_If_Swap(ad.total_cost, j, max_i));
 #if defined(DEBUG) && (DEBUG&1)
       swap[j] = x;
 #endif
@@ -255,6 +381,13 @@ Select_Var_Min_Conflict(void)
 
       if (x <= new_cost)
 	{
+	  if (__builtin_expect(tabu_on, 0) && x >= ad.total_cost && j != max_i &&
+	      Tabu_Seen(Move_Hash(j, max_i)))
+	    {
+	      ad.nb_tabu++;
+	      continue;
+	    }
+
 	  if (x < new_cost)
 	    {
 	      list_j_nb = 0;
@@ -318,17 +451,23 @@ Select_Vars_To_Swap(void)
   nb_var_marked = 0;
 
   i = -1;
-  while((unsigned) (i = Next_I(i)) < (unsigned) ad.size) // false if i < 0
+  while((unsigned) (i = Prof_Call(PROF_NEXT_I, Next_I(i))) < (unsigned) ad.size) // false if i < 0
     {
+      if (block_var && !in_block[i])
+	continue;
+
       if (Marked(i))
 	{
 	  nb_var_marked++;
 	  continue;
 	}
       j = -1;
-      while((unsigned) (j = Next_J(i, j)) < (unsigned) ad.size) // false if j < 0
+      while((unsigned) (j = Prof_Call(PROF_NEXT_J, Next_J(i, j))) < (unsigned) ad.size) // false if j < 0
 	{
-	  x = Cost_If_Swap(ad.total_cost, i, j);
+	  if (block_var && !in_block[j])
+	    continue;
+
+	  x = Prof_Call(PROF_COST_IF_SWAP, Cost_If_Swap(ad.total_cost, i, j));
 
 #ifndef IGNORE_MARK_IF_BEST
 	  if (Marked(j))
@@ -340,6 +479,13 @@ Select_Vars_To_Swap(void)
 
 	  if (x <= new_cost)
 	    {
+	      if (__builtin_expect(tabu_on, 0) && x >= ad.total_cost &&
+		  Tabu_Seen(Move_Hash(i, j)))
+		{
+		  ad.nb_tabu++;
+		  continue;
+		}
+
 	      if (x < new_cost)
 		{
 		  new_cost = x;
@@ -398,6 +544,101 @@ Select_Vars_To_Swap(void)
 
 
 
+/*
+ *  ADD_FOOTPRINT
+ *
+ *  Adds the constraints changed by swapping i and j to used_cstr if they
+ *  are disjoint from the ones already there. Returns 0 if they are not.
+ */
+static int
+Add_Footprint(int i, int j)
+{
+  int *p = used_cstr + used_nb;
+  int n, k, l;
+
+  n = Swap_Footprint(i, j, p);
+  if (n < 0)
+    return 0;
+
+  for(k = 0; k < n; k++)
+    for(l = 0; l < used_nb; l++)
+      if (p[k] == used_cstr[l])
+	return 0;
+
+  used_nb += n;
+  return 1;
+}
+
+
+
+
+/*
+ *  SELECT_EXTRA_SWAPS
+ *
+ *  Called when max_i/min_j is an improving swap: selects up to
+ *  multi_swap - 1 other improving swaps (the var of highest cost, from
+ *  var_cost, with the first improving partner found from a random start)
+ *  whose footprints are disjoint from the ones already selected. Only the
+ *  vars with a cost (var_cost > 0, i.e. neither marked nor already used)
+ *  are tried as partners, so each extra swap rarely needs a full scan.
+ *  Their cost variations are computed on the same configuration, disjoint
+ *  footprints make them independent.
+ */
+static void
+Select_Extra_Swaps(void)
+{
+  int n = Nb_Cand, nb_try = 2 * (ad.multi_swap - 1);
+  int i, j, k, l, x, best, best_j;
+
+  extra_nb = 0;
+  extra_delta = 0;
+  used_nb = 0;
+  if (!Add_Footprint(max_i, min_j))
+    return;
+  var_cost[max_i] = var_cost[min_j] = -1;
+
+  while(extra_nb < ad.multi_swap - 1 && nb_try-- > 0)
+    {
+      for(i = -1, best = 0, k = 0; k < n; k++)
+	if (var_cost[Cand(k)] > best)
+	  {
+	    i = Cand(k);
+	    best = var_cost[i];
+	  }
+      if (i < 0)
+	break;
+      var_cost[i] = -1;
+
+      best = ad.total_cost;
+      best_j = -1;
+      for(k = 0, l = (int) Random(n); k < n && best_j < 0; k++, l = (l + 1 < n) ? l + 1 : 0)
+	{
+	  j = Cand(l);
+	  if (var_cost[j] <= 0)
+	    continue;
+
+	  x = Prof_Call(PROF_COST_IF_SWAP, Cost_If_Swap(ad.total_cost, j, i));
+	  if (x < best)
+	    {
+	      best = x;
+	      best_j = j;
+	    }
+	}
+
+      if (best_j < 0 || !Add_Footprint(i, best_j))
+	continue;
+
+      var_cost[best_j] = -1;
+      extra_swap[extra_nb].i = i;
+      extra_swap[extra_nb].j = best_j;
+      extra_nb++;
+      extra_delta += best - ad.total_cost;
+    }
+}
+
+
+
+
 /*
  *  SWAP
  *
@@ -409,6 +650,11 @@ Swap(int i, int j)
   int x;
 
   ad.nb_swap++;
+  if (__builtin_expect(tabu_on, 0))
+    {
+      config_hash = Move_Hash(i, j);
+      Tabu_Record(config_hash);
+    }
   x = ad.sol[i];
   ad.sol[i] = ad.sol[j];
   ad.sol[j] = x;
@@ -416,172 +662,1187 @@ Swap(int i, int j)
 
 
 
+/*
+ *  MULTI_SWAP
+ *
+ *  Performs the extra swaps selected by Select_Extra_Swaps.
+ */
 static void
-Reset(int n)
+Multi_Swap(void)
 {
-  while(n--)
-    {
-      max_i = Random(ad.size);
-      min_j = Random(ad.size);
-      Swap(max_i, min_j);
+  int k, i, j;
 
-#if UNMARK_AT_RESET == 1
-      UnMark(max_i);
-      UnMark(min_j);
-#endif
+  for(k = 0; k < extra_nb; k++)
+    {
+      i = extra_swap[k].i;
+      j = extra_swap[k].j;
+      Mark(i, ad.freeze_swap);
+      Mark(j, ad.freeze_swap);
+      Swap(i, j);
+      Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap(i, j));
     }
 
-#if UNMARK_AT_RESET == 2
-  memset(mark, 0, ad.size * sizeof(unsigned));
-#endif
-  ad.nb_reset++;
-  ad.total_cost = Cost_Of_Solution(1);
+  ad.total_cost += extra_delta;
+  ad.nb_extra_swap += extra_nb;
+  extra_nb = 0;
 }
 
 
 
+
 /*
- *  EMIT_LOG
+ *  TRY_COMPOUND
  *
+ *  Called on a local min (no swap of max_i improves): tries the 3-cycles
+ *  of max_i with compound_moves random partners j and any k, i.e. the swap
+ *  of max_i and j followed by the swap of max_i and k (see Cost_If_Cycle).
+ *  Performs the best one if it improves the cost and returns 1, else 0.
+ *  Not used if the model restricts the swaps (user Next_I or Next_J).
  */
-#ifdef LOG_FILE
-#define Emit_Log(...)					\
-  do if (f_log)						\
-    {							\
-      fprintf(f_log, __VA_ARGS__);			\
-      fputc('\n', f_log);				\
-      fflush(f_log);					\
-  } while(0)
-#else
-#define Emit_Log(...)
-#endif
+static int
+Try_Compound(void)
+{
+  int i = max_i, n = Nb_Cand;
+  int t, j, k, l, x, best, best_j, best_k, nb_best;
+
+  best = ad.total_cost;
+  best_j = best_k = -1;
+  nb_best = 0;
+
+  for(t = 0; t < ad.compound_moves; t++)
+    {
+      j = Cand((int) Random(n));
+      if (j == i || Marked(j))
+	continue;
+
+      for(l = 0; l < n; l++)
+	{
+	  k = Cand(l);
+	  if (k == i || k == j || Marked(k))
+	    continue;
+
+	  x = Cost_If_Cycle(ad.total_cost, i, j, k);
+	  if (x < best)
+	    {
+	      best = x;
+	      best_j = j;
+	      best_k = k;
+	      nb_best = 1;
+	    }
+	  else if (x == best && best_j >= 0 && Random(++nb_best) == 0)
+	    {
+	      best_j = j;
+	      best_k = k;
+	    }
+	}
+    }
+
+  if (best_j < 0)
+    return 0;
+
+  j = best_j;
+  k = best_k;
+  Mark(i, ad.freeze_swap);
+  Mark(j, ad.freeze_swap);
+  Mark(k, ad.freeze_swap);
+				/* as i < j (as Next_I/Next_J): some models need it */
+  Swap(i, j);
+  Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap((i < j) ? i : j, (i < j) ? j : i));
+  Swap(i, k);
+  Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap((i < k) ? i : k, (i < k) ? k : i));
+
+  ad.total_cost = best;
+  ad.nb_compound++;
+  return 1;
+}
 
 
 
 
 /*
- *  SOLVE
+ *  ENDGAME_MOVE
  *
- *  General solve function.
- *  returns the final total_cost (0 on success)
+ *  Swaps i and j (i < j) in an endgame search. Unlike Swap it neither counts
+ *  the swap nor records the configuration (the search is undone).
  */
-int
-Ad_Solve(AdData *p_ad)
+static void
+Endgame_Move(int i, int j)
 {
-  int nb_in_plateau;
+  int x;
 
-  ad = *p_ad;	   /* does this help gcc optim (put some fields in regs) ? */
+  x = ad.sol[i];
+  ad.sol[i] = ad.sol[j];
+  ad.sol[j] = x;
+  Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap(i, j));
+}
 
-  ad_sol = ad.sol; /* copy of p_ad->sol and p_ad->reinit_after_if_swap (used by no_cost_swap) */
-  ad_reinit_after_if_swap = p_ad->reinit_after_if_swap;
 
 
-  if (ad_no_cost_var_fct)
-    ad.exhaustive = 1;
 
+/*
+ *  ENDGAME_SEARCH
+ *
+ *  Depth-first search of a solution from the current configuration (of cost
+ *  cost), level swaps being done. The swaps considered exchange a var with
+ *  a cost (at most ENDGAME_MAX_VAR of them, all vars if Cost_On_Variable
+ *  is not defined) and any var, only the ENDGAME_WIDTH best ones are
+ *  explored. On success returns 1 with the swaps in
+ *  endgame_path[0..endgame_len-1] (the configuration is restored).
+ */
+static int
+Endgame_Search(int level, int cost)
+{
+  Pair *cand = endgame_cand[level];
+  int *cand_cost = endgame_cost[level];
+  int n = Nb_Cand, nb_conf = 0, nb = 0;
+  int i, j, k, l, m, x, found;
 
-  mark = (unsigned *) malloc(ad.size * sizeof(unsigned));
-  if (ad.exhaustive <= 0)
+  for(l = 0; l < n; l++)
     {
-      list_i = (int *) malloc(ad.size * sizeof(int));
-      list_j = (int *) malloc(ad.size * sizeof(int));
+      i = Cand(l);
+      endgame_conf[i] = (ad_no_cost_var_fct || Prof_Call(PROF_COST_ON_VAR, Cost_On_Variable(i)) > 0);
+      if (endgame_conf[i] && ++nb_conf > ENDGAME_MAX_VAR && !ad_no_cost_var_fct)
+	return 0;
     }
-  else
-    list_ij = (Pair *) malloc(ad.size * sizeof(Pair)); // to run on Cell limit to ad.size instead of ad.size*ad.size
 
-#if defined(DEBUG) && (DEBUG&1)
-  err_var = (int *) malloc(ad.size * sizeof(int));
-  swap = (int *) malloc(ad.size * sizeof(int));
-#endif
+  for(k = 0; k < n; k++)
+    {
+      i = Cand(k);
+      if (!endgame_conf[i])
+	continue;
 
-  if (mark == NULL || (!ad.exhaustive && (list_i == NULL || list_j == NULL)) || (ad.exhaustive && list_ij == NULL)
-#if defined(DEBUG) && (DEBUG&1)
-      || err_var == NULL || swap == NULL
-#endif
-      )
+      for(l = 0; l < n; l++)
+	{
+	  j = Cand(l);
+	  if (j == i || (endgame_conf[j] && j < i))	/* each pair once */
+	    continue;
+
+	  x = (i < j) ? i : j;
+	  j = (i < j) ? j : i;
+	  if (level > 0 && x == endgame_path[level - 1].i && j == endgame_path[level - 1].j)
+	    continue;		/* undoes the previous swap */
+
+	  found = Prof_Call(PROF_COST_IF_SWAP, Cost_If_Swap(cost, x, j));
+	  if (found == 0)
+	    {
+	      endgame_path[level].i = x;
+	      endgame_path[level].j = j;
+	      endgame_len = level + 1;
+	      return 1;
+	    }
+
+	  if (level + 1 == ENDGAME_DEPTH || (nb == ENDGAME_WIDTH && found >= cand_cost[nb - 1]))
+	    continue;
+				/* insert in the (sorted) best swaps */
+	  if (nb < ENDGAME_WIDTH)
+	    nb++;
+	  for(m = nb - 1; m > 0 && cand_cost[m - 1] > found; m--)
+	    {
+	      cand[m] = cand[m - 1];
+	      cand_cost[m] = cand_cost[m - 1];
+	    }
+	  cand[m].i = x;
+	  cand[m].j = j;
+	  cand_cost[m] = found;
+	}
+    }
+
+  for(k = 0; k < nb; k++)
     {
-      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
-      exit(1);
+      endgame_path[level] = cand[k];
+      Endgame_Move(cand[k].i, cand[k].j);
+      found = Endgame_Search(level + 1, cand_cost[k]);
+      Endgame_Move(cand[k].i, cand[k].j);
+      if (found)
+	return 1;
     }
 
-  memset(mark, 0, ad.size * sizeof(unsigned)); /* init with 0 */
+  return 0;
+}
 
-#ifdef LOG_FILE
-  f_log = NULL;
-  if (ad.log_file)
-    if ((f_log = fopen(ad.log_file, "w")) == NULL)
-      perror(ad.log_file);
-#endif
 
-  ad.nb_restart = -1;
 
-  ad.nb_iter = 0;
-  ad.nb_swap = 0;
-  ad.nb_same_var = 0;
-  ad.nb_reset = 0;
-  ad.nb_local_min = 0;
 
-  ad.nb_iter_tot = 0;
-  ad.nb_swap_tot = 0;
-  ad.nb_same_var_tot = 0;
-  ad.nb_reset_tot = 0;
-  ad.nb_local_min_tot = 0;
+/*
+ *  TRY_ENDGAME
+ *
+ *  Called on a local min of cost <= endgame_cost: searches a solution with
+ *  a few swaps (see Endgame_Search) and performs them if found (returns 1,
+ *  else 0 and the adaptive search goes on). The cost is then recomputed
+ *  with Cost_Of_Solution (not assumed to be 0). The search is not redone
+ *  while no swap was done since the last failure (same configuration).
+ */
+static int
+Try_Endgame(void)
+{
+  int k;
 
-#if defined(DEBUG) && (DEBUG&2)
-  if (ad.do_not_init)
+  if (ad.nb_swap == endgame_fail_swap)
+    return 0;
+
+  ad.nb_endgame++;
+  if (!Endgame_Search(0, ad.total_cost))
     {
-      printf ("********* received data (do_not_init=1):\n");
-      Ad_Display(ad.sol, &ad, NULL);
-      printf("******************************-\n");
+      endgame_fail_swap = ad.nb_swap;
+      return 0;
     }
-#endif
 
-  if (!ad.do_not_init)
+  for(k = 0; k < endgame_len; k++)
     {
-    restart:
-      ad.nb_iter_tot += ad.nb_iter; 
-      ad.nb_swap_tot += ad.nb_swap; 
-      ad.nb_same_var_tot += ad.nb_same_var;
-      ad.nb_reset_tot += ad.nb_reset;
-      ad.nb_local_min_tot += ad.nb_local_min;
+      Swap(endgame_path[k].i, endgame_path[k].j);
+      Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap(endgame_path[k].i, endgame_path[k].j));
+    }
 
-      Random_Permut(ad.sol, ad.size, ad.actual_value, ad.base_value);
-      memset(mark, 0, ad.size * sizeof(unsigned)); /* init with 0 */
+  ad.total_cost = Prof_Call(PROF_COST_OF_SOL, Cost_Of_Solution(1));
+  if (ad.total_cost == 0)
+    ad.nb_endgame_ok++;
+  return 1;
+}
+
+
+
+
+/*
+ *  RAISE_WEIGHTS
+ *
+ *  Called before a reset: increments the weight of each violated constraint
+ *  (so the next descent works first on the constraints which keep resisting)
+ *  and halves all weights (rounding up, so they stay >= 1) every weight_decay
+ *  raises. The (weighted) cost of the model is then recomputed.
+ */
+static void
+Raise_Weights(void)
+{
+  int n, k;
+
+  n = Violated_Constraints(weight_cstr);
+  for(k = 0; k < n; k++)
+    ad_weight[weight_cstr[k]]++;
+
+  if (--weight_countdown <= 0)
+    {
+      weight_countdown = ad.weight_decay;
+      for(k = 0; k < ad_nb_weight; k++)
+	ad_weight[k] = (ad_weight[k] + 1) / 2;
     }
 
-  ad.nb_restart++;
-  ad.nb_iter = 0;
-  ad.nb_swap = 0;
-  ad.nb_same_var = 0;
-  ad.nb_reset = 0;
-  ad.nb_local_min = 0;
+  ad.nb_weight_raise++;
+  ad.total_cost = Prof_Call(PROF_COST_OF_SOL_RESET, Cost_Of_Solution(1));
+}
 
 
-  nb_in_plateau = 0;
 
-  best_cost = ad.total_cost = Cost_Of_Solution(1);
 
-  while(ad.total_cost)
+/*
+ *  SELECT_WORST
+ *
+ *  Puts in reset_var[0..n-1] the n variables of highest cost (quickselect).
+ */
+static void
+Select_Worst(int n)
+{
+  int lo = 0, hi = ad.size - 1;
+  int i, j, x, pivot;
+
+  for(i = 0; i < ad.size; i++)
     {
-      ad.nb_iter++;
+      reset_var[i] = i;
+      reset_err[i] = Prof_Call(PROF_COST_ON_VAR, Cost_On_Variable(i));
+    }
 
-#ifdef CELL_COMM
-      int comm_cost = (1 << 30);
-      while(as_mbx_avail())
-	{
-	  int c= as_mbx_read();
-	  if (c < comm_cost)
-	    comm_cost = c;
-	  usleep(1000);
-	}
-      if (1)
+  while(lo < hi)
+    {
+      pivot = reset_err[reset_var[lo + Random(hi - lo + 1)]];
+      i = lo;
+      j = hi;
+      while(i <= j)
 	{
-	  //	  int comm_cost = as_mbx_read();
-#ifdef CELL_COMM_ACTION_CMD
-	  if (ad.total_cost > comm_cost && Random(100) < (unsigned) CELL_COMM_PROB_ACCEPT)
+	  while(reset_err[reset_var[i]] > pivot)
+	    i++;
+	  while(reset_err[reset_var[j]] < pivot)
+	    j--;
+	  if (i <= j)
 	    {
-	      int n;
-	      //n = (ad.size - (comm_cost * ad.size / ad.total_cost)) / 10;
+	      x = reset_var[i];
+	      reset_var[i++] = reset_var[j];
+	      reset_var[j--] = x;
+	    }
+	}
+
+      if (n - 1 <= j)
+	hi = j;
+      else if (n - 1 >= i)
+	lo = i;
+      else
+	break;
+    }
+}
+
+
+
+
+/*
+ *  RESET_TARGETED
+ *
+ *  Resets n variables (the worst ones or the frozen ones completed with
+ *  random ones) by swapping each with a random variable (as i < j, like
+ *  the default Next_I/Next_J). Only these variables are unmarked. The cost
+ *  is maintained with Cost_If_Swap and Executed_Swap, except if the model
+ *  restricts the swaps (user Next_I or Next_J): its incremental functions
+ *  may not handle any swap.
+ */
+static void
+Reset_Targeted(int n)
+{
+  int incremental = ad_no_next_i_fct && ad_no_next_j_fct;
+  int i, j, k, nb = 0;
+  int cost = 0;
+
+  if (n > ad.size)
+    n = ad.size;
+
+  if (ad.reset_strategy == AD_RESET_WORST && !ad_no_cost_var_fct)
+    {
+      Select_Worst(n);
+      nb = n;
+    }
+  else
+    {
+      for(i = 0; i < ad.size && nb < n; i++)
+	if (Marked(i))
+	  reset_var[nb++] = i;
+
+      while(nb < n)
+	reset_var[nb++] = Random(ad.size);
+    }
+
+  for(k = 0; k < nb; k++)
+    {
+      i = reset_var[k];
+      j = Random(ad.size);
+      if (i == j)
+	continue;
+
+      if (i > j)		/* as Next_I/Next_J: some models need i < j */
+	{
+	  i = j;
+	  j = reset_var[k];
+	}
+
+      if (incremental)
+	cost = Prof_Call(PROF_COST_IF_SWAP, Cost_If_Swap(ad.total_cost, i, j));
+      Swap(i, j);
+      if (incremental)
+	{
+	  Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap(i, j));
+	  ad.total_cost = cost;
+	}
+      UnMark(i);
+      UnMark(j);
+    }
+
+  ad.nb_reset++;
+  if (!incremental)
+    ad.total_cost = Prof_Call(PROF_COST_OF_SOL_RESET, Cost_Of_Solution(1));
+}
+
+
+
+
+static void
+Reset(int n)
+{
+  if (ad.reset_strategy != AD_RESET_RANDOM)
+    {
+      Reset_Targeted(n);
+      return;
+    }
+
+  while(n--)
+    {
+      max_i = Cand((int) Random(Nb_Cand));
+      min_j = Cand((int) Random(Nb_Cand));
+      Swap(max_i, min_j);
+
+#if UNMARK_AT_RESET == 1
+      UnMark(max_i);
+      UnMark(min_j);
+#endif
+    }
+
+#if UNMARK_AT_RESET == 2
+  memset(mark, 0, ad.size * sizeof(unsigned));
+#endif
+  ad.nb_reset++;
+  ad.total_cost = Prof_Call(PROF_COST_OF_SOL_RESET, Cost_Of_Solution(1));
+}
+
+
+
+
+
+
+
+/*
+ *  LUBY
+ *
+ *  Returns the ith term (i >= 1) of the Luby sequence 1 1 2 1 1 2 4 1 1 2...
+ */
+static int
+Luby(int i)
+{
+  int k;
+
+  for(;;)
+    {
+      for(k = 1; (1 << k) - 1 < i; k++)
+	;
+      if (i == (1 << k) - 1)
+	return 1 << (k - 1);
+      i -= (1 << (k - 1)) - 1;
+    }
+}
+
+
+
+
+/*
+ *  RESTART_LIMIT
+ *
+ *  Returns the nb of iters of the current restart (wrt restart_policy).
+ */
+static int
+Restart_Limit(void)
+{
+  double n;
+  int k;
+
+  switch(ad.restart_policy)
+    {
+    case AD_RESTART_LUBY:
+      n = (double) ad.restart_limit * Luby(ad.nb_restart + 1);
+      break;
+
+    case AD_RESTART_GEOM:
+      n = ad.restart_limit;
+      for(k = 0; k < ad.nb_restart && n < BIG; k++)
+	n = n * ad.restart_factor / 100;
+      break;
+
+    case AD_RESTART_STAG:		/* tested wrt the last improvement */
+      return (int) BIG;
+
+    default:
+      return ad.restart_limit;
+    }
+
+  return (n < BIG) ? (int) n : (int) BIG;
+}
+
+
+
+
+/*
+ *  ADAPT_START
+ *
+ *  Starts a new window of the adaptive controller.
+ */
+static void
+Adapt_Start(void)
+{
+  adapt_best_cost = best_cost;
+  adapt_nb_local_min = ad.nb_local_min;
+  adapt_nb_reset = ad.nb_reset;
+  adapt_plateau = 0;
+}
+
+
+
+
+#define Adapt_Toward(x, x0)  ((x) += ((x0) - (x)) / 2)
+
+#define Adapt_Raise(x, x0)   ((x) = Adapt_Bound((x) * 3 / 2 + 1, (x0)))
+
+#define Adapt_Lower(x, x0)   ((x) = Adapt_Bound((x) - ((x) + 3) / 4, (x0)))
+
+				/* stay in [x0/4, 4*x0+2] and [1, size] */
+#define Adapt_Bound(x, x0)						\
+  Adapt_Max(Adapt_Min(Adapt_Min((x), 4 * (x0) + 2), ad.size), Adapt_Max((x0) / 4, 1))
+
+#define Adapt_Min(x, y)      (((x) < (y)) ? (x) : (y))
+#define Adapt_Max(x, y)      (((x) > (y)) ? (x) : (y))
+
+
+/*
+ *  ADAPT
+ *
+ *  Adaptive controller, called at the end of each window of adapt_window
+ *  iterations. If the best cost has improved, the parameters move back
+ *  toward their initial values. Else the search stagnates and is
+ *  diversified:
+ *  - resets occurred (and did not help): reset more variables,
+ *  - many local mins but no reset: the marks expire before reset_limit is
+ *    reached, freeze local min vars longer and reset sooner,
+ *  - long plateaus: select local mins more often (if -P is used),
+ *  - else: freeze swapped vars longer (to avoid cycles).
+ *  A value stays within a factor 4 of its initial value (and the size).
+ */
+static void
+Adapt(int nb_in_plateau)
+{
+  int nb_local_min = ad.nb_local_min - adapt_nb_local_min;
+  int nb_reset = ad.nb_reset - adapt_nb_reset;
+  int plateau = (nb_in_plateau > adapt_plateau) ? nb_in_plateau : adapt_plateau;
+  int why;
+
+  if (best_cost < adapt_best_cost)
+    {
+      why = TR_ADAPT_IMPROVED;
+      Adapt_Toward(ad.prob_select_loc_min, adapt_init.prob_select_loc_min);
+      Adapt_Toward(ad.freeze_loc_min, adapt_init.freeze_loc_min);
+      Adapt_Toward(ad.freeze_swap, adapt_init.freeze_swap);
+      Adapt_Toward(ad.reset_limit, adapt_init.reset_limit);
+      Adapt_Toward(ad.nb_var_to_reset, adapt_init.nb_var_to_reset);
+    }
+  else if (nb_reset > 0)
+    {
+      why = TR_ADAPT_STAG_RESET;
+      Adapt_Raise(ad.nb_var_to_reset, adapt_init.nb_var_to_reset);
+    }
+  else if (nb_local_min * ADAPT_MANY_LOC_MIN >= ad.adapt_window)
+    {
+      why = TR_ADAPT_STAG_LOC_MIN;
+      Adapt_Raise(ad.freeze_loc_min, adapt_init.freeze_loc_min);
+      Adapt_Lower(ad.reset_limit, adapt_init.reset_limit);
+    }
+  else if (USE_PROB_SELECT_LOC_MIN && plateau > ad.size)
+    {
+      why = TR_ADAPT_STAG_PLATEAU;
+      ad.prob_select_loc_min += 10;
+      if (ad.prob_select_loc_min > 100)
+	ad.prob_select_loc_min = 100;
+    }
+  else
+    {
+      why = TR_ADAPT_STAG;
+      Adapt_Raise(ad.freeze_swap, adapt_init.freeze_swap);
+    }
+
+  ad.nb_adapt++;
+
+  Trace_Event(TR_ADAPT, ad.nb_iter, ad.total_cost, why,
+	      ad.prob_select_loc_min, ad.freeze_loc_min, ad.freeze_swap,
+	      ad.reset_limit, ad.nb_var_to_reset);
+#ifdef TRACE
+  static char *why_name[] = TR_ADAPT_NAMES;
+
+  printf("ADAPT (%s) iter: %d best: %d loc min: %d resets: %d plateau: %d"
+	 " -> P: %d f: %d F: %d l: %d reset: %d\n",
+	 why_name[why], ad.nb_iter, best_cost, nb_local_min, nb_reset, plateau,
+	 ad.prob_select_loc_min, ad.freeze_loc_min, ad.freeze_swap,
+	 ad.reset_limit, ad.nb_var_to_reset);
+#else
+  (void) why;
+  (void) plateau;
+#endif
+
+  Adapt_Start();
+}
+
+
+
+
+/*
+ *  PUBLISH_TELEMETRY
+ *
+ *  Publishes the live status (see telemetry.h).
+ */
+static void
+Publish_Telemetry(int state)
+{
+  AdTelemetry v;
+
+  if (best_cost < tele_best_cost)
+    tele_best_cost = best_cost;
+
+  v.state = state;
+  v.seed = ad.seed;
+  v.cost = ad.total_cost;
+  v.best_cost = tele_best_cost;
+  v.nb_restart = ad.nb_restart;
+  v.nb_iter = ad.nb_iter;
+  v.nb_iter_tot = (long long) ad.nb_iter_tot + ad.nb_iter;
+  v.nb_reset = ad.nb_reset_tot + ad.nb_reset;
+  v.nb_local_min = ad.nb_local_min_tot + ad.nb_local_min;
+  v.nb_marked = nb_var_marked;
+
+  Telemetry_Publish(&v);
+}
+
+
+
+
+/*
+ *  SHADOW_VERIFY
+ *
+ *  Checks (sampled) the incremental total_cost and new_cost (given by
+ *  Cost_If_Swap for the selected swap) against Cost_Of_Solution computed
+ *  from scratch. The last call rebuilds the state of the model (as a reset
+ *  does): it is unchanged if the model is right, else the search goes on
+ *  with the true costs. new_cost is only checked if it comes from a swap
+ *  actually evaluated.
+ */
+static void
+Shadow_Verify(void)
+{
+  int cost, swap_cost = new_cost;
+  int x;
+
+  if (ad.verify_interval > 0)
+    {
+      if (--verify_countdown > 0)
+	return;
+      verify_countdown = ad.verify_interval;
+    }
+  else
+    {
+      verify_rand ^= verify_rand << 13;	/* xorshift32 */
+      verify_rand ^= verify_rand >> 17;
+      verify_rand ^= verify_rand << 5;
+      if (verify_rand % 1000000 >= (unsigned) ad.verify_ppm)
+	return;
+    }
+
+  ad.nb_verify++;
+
+  if (min_j >= 0 && min_j != max_i && (ad.exhaustive || list_j_nb > 0))
+    {
+      x = ad.sol[max_i];
+      ad.sol[max_i] = ad.sol[min_j];
+      ad.sol[min_j] = x;
+
+      swap_cost = Cost_Of_Solution(0);
+
+      ad.sol[min_j] = ad.sol[max_i];
+      ad.sol[max_i] = x;
+    }
+
+  cost = Cost_Of_Solution(1);
+
+  if (cost == ad.total_cost && swap_cost == new_cost)
+    return;
+
+  if (ad.nb_verify_fail++ == 0)
+    ad.verify_fail_iter = ad.nb_iter_tot + ad.nb_iter;
+
+  DPRINTF("iter %d: total_cost %d (true %d), swap %d/%d new_cost %d (true %d)\n",
+	  ad.nb_iter, ad.total_cost, cost, max_i, min_j, new_cost, swap_cost);
+
+  ad.total_cost = cost;
+  new_cost = swap_cost;
+}
+
+
+
+
+/*
+ *  RECORD_SOLUTION
+ *
+ *  Called on a solution when enumerating (nb_solutions > 1). Solutions are
+ *  identified by their hash (open addressing set, never full since it has
+ *  at least 2*nb_solutions entries). Calls on_solution for a new one.
+ *  Returns true if the enumeration goes on.
+ */
+static int
+Record_Solution(void)
+{
+  unsigned long long h = (tabu_on) ? config_hash : Ad_Hash(ad.sol, ad.size);
+  unsigned k;
+
+  if (h == 0)
+    h = 1;
+
+  for(k = (unsigned) h & sol_mask; sol_set[k] != 0; k = (k + 1) & sol_mask)
+    if (sol_set[k] == h)
+      {
+	ad.nb_sol_dup++;
+	return 1;
+      }
+
+  sol_set[k] = h;
+  ad.nb_sol_found++;
+
+  if (Observed && Notify(on_solution, ad.nb_sol_found))
+    return 0;
+
+  return ad.nb_sol_found < ad.nb_solutions;
+}
+
+
+
+
+#if !defined(CELL)
+/*
+ *  BLOCK_JOB
+ *
+ *  Run by a worker process (see multi.c): searches block no of the current
+ *  round, the other variables keeping their values. The result is the
+ *  cost of the configuration reached, the nb of iters and the values of
+ *  the vars of the block.
+ */
+static void
+Block_Job(int no, void *result)
+{
+  int *res = (int *) result;
+  AdData w = ad;
+  int k;
+
+  trace_on = 0;			/* belong to the parent process */
+  telemetry_on = 0;
+  Randomize_Seed(Random(65536) * 1024 + no);
+
+  block_var = block_part + no * block_len;
+  block_nb = (ad.size - no + ad.nb_blocks - 1) / ad.nb_blocks;
+  for(k = 0; k < block_nb; k++)
+    in_block[block_var[k]] = 1;
+
+  w.do_not_init = 1;
+  w.restart_limit = BLOCK_STAG_ITER;
+  w.restart_max = 0;
+  w.restart_policy = AD_RESTART_STAG;
+  w.reset_strategy = AD_RESET_RANDOM;
+  w.reset_limit = Div_Round_Up((long long) ad.reset_limit * block_nb, ad.size);
+  w.nb_var_to_reset = Div_Round_Up((long long) ad.nb_var_to_reset * block_nb, ad.size);
+  w.log_file = NULL;
+  w.stat_interval = 0;
+  w.landscape = 0;
+  w.nb_solutions = 0;
+  w.observer = NULL;
+
+  Ad_Solve(&w);
+
+  res[0] = w.total_cost;
+  res[1] = w.nb_iter_tot;
+  for(k = 0; k < block_nb; k++)
+    res[2 + k] = w.sol[block_var[k]];
+}
+
+
+
+
+/*
+ *  DECOMPOSE
+ *
+ *  Repairs the current configuration by rounds of nb_blocks disjoint blocks
+ *  searched in parallel (one process each). The conflicting variables
+ *  (Cost_On_Variable > 0) are dealt first among the blocks, then the other
+ *  ones (random order). A block only permutes its own values, so merging
+ *  the blocks gives a permutation. Since the blocks interact, the merged
+ *  configuration is only kept if it is not worse than the best block
+ *  applied alone. Stops when a round does not improve the cost.
+ */
+static void
+Decompose(void)
+{
+  int size = ad.size, nb = ad.nb_blocks;
+  int *order, *merged, *save, *res;
+  int i, k, b, no, nb_conflict;
+  int cost, best_block, best_block_cost;
+
+  block_len = Div_Round_Up(size, nb);
+  order = (int *) malloc(size * sizeof(int));
+  merged = (int *) malloc(size * sizeof(int));
+  save = (int *) malloc(size * sizeof(int));
+  block_part = (int *) malloc(nb * block_len * sizeof(int));
+  in_block = (char *) calloc(size, sizeof(char));
+  res = (int *) malloc((2 + block_len) * sizeof(int));
+  if (order == NULL || merged == NULL || save == NULL || block_part == NULL ||
+      in_block == NULL || res == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  ad.total_cost = Prof_Call(PROF_COST_OF_SOL, Cost_Of_Solution(1));
+
+  while(ad.total_cost > 0)
+    {
+      ad.nb_block_round++;
+      cost = ad.total_cost;
+
+      for(i = 0; i < size; i++)	/* random order, conflicting vars first */
+	{
+	  k = Random(i + 1);
+	  order[i] = order[k];
+	  order[k] = i;
+	}
+      nb_conflict = 0;
+      if (!ad_no_cost_var_fct)
+	for(i = 0; i < size; i++)
+	  if (Cost_On_Variable(order[i]) > 0)
+	    {
+	      k = order[nb_conflict];
+	      order[nb_conflict++] = order[i];
+	      order[i] = k;
+	    }
+
+      for(i = 0; i < size; i++)	/* deal them among the blocks */
+	block_part[(i % nb) * block_len + i / nb] = order[i];
+
+      memcpy(merged, ad.sol, size * sizeof(int));
+      best_block = -1;
+      best_block_cost = BIG;
+
+      Multi_Start(0, nb, (2 + block_len) * sizeof(int), Block_Job);
+      while((k = Multi_Next(res, &no)) >= 0)
+	{
+	  if (k == 0)
+	    continue;
+
+	  ad.nb_block_iter += res[1];
+	  b = (size - no + nb - 1) / nb;
+	  for(i = 0; i < b; i++)
+	    merged[block_part[no * block_len + i]] = res[2 + i];
+
+	  if (res[0] < best_block_cost)
+	    {
+	      best_block_cost = res[0];
+	      best_block = no;
+	    }
+	}
+      Multi_Stop();
+
+      if (best_block < 0)	/* no result (workers killed) */
+	break;
+
+      memcpy(save, ad.sol, size * sizeof(int));
+      memcpy(ad.sol, merged, size * sizeof(int));
+      ad.total_cost = Prof_Call(PROF_COST_OF_SOL, Cost_Of_Solution(1));
+
+      if (ad.total_cost > best_block_cost) /* apply the best block alone */
+	{
+	  memcpy(ad.sol, save, size * sizeof(int));
+	  b = (size - best_block + nb - 1) / nb;
+	  for(i = 0; i < b; i++)
+	    {
+	      k = block_part[best_block * block_len + i];
+	      ad.sol[k] = merged[k];
+	    }
+	  ad.total_cost = Prof_Call(PROF_COST_OF_SOL, Cost_Of_Solution(1));
+	}
+
+      if (ad.total_cost >= cost)
+	break;
+    }
+
+  free(order);
+  free(merged);
+  free(save);
+  free(block_part);
+  free(in_block);
+  free(res);
+  block_part = NULL;
+  in_block = NULL;
+}
+#endif	/* !CELL */
+
+
+
+
+/*
+ *  AD_WEIGHT_INIT
+ *
+ *  Called by a bench (in Solve) whose cost functions weight its nb_cstr
+ *  constraints with ad_weight[]: all weights are set to 1 (they only
+ *  change with weight_decay > 0, see Raise_Weights).
+ */
+void
+Ad_Weight_Init(int nb_cstr)
+{
+  int k;
+
+  if (nb_cstr > ad_nb_weight)
+    {
+      ad_weight = (int *) realloc(ad_weight, nb_cstr * sizeof(int));
+      if (ad_weight == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+  ad_nb_weight = nb_cstr;
+
+  for(k = 0; k < nb_cstr; k++)
+    ad_weight[k] = 1;
+}
+
+
+
+
+/*
+ *  SOLVE
+ *
+ *  General solve function.
+ *  returns the final total_cost (0 on success)
+ */
+int
+Ad_Solve(AdData *p_ad)
+{
+  int nb_in_plateau;
+  int restart_limit;		/* nb of iters of the current restart */
+  int best_iter;		/* iter where best_cost has been reached */
+  Prof_Start(prof_solve_t0);
+
+  ad = *p_ad;	   /* does this help gcc optim (put some fields in regs) ? */
+
+  ad_sol = ad.sol; /* copy of p_ad->sol and p_ad->reinit_after_if_swap (used by no_cost_swap) */
+  ad_reinit_after_if_swap = p_ad->reinit_after_if_swap;
+
+
+  if (ad_no_cost_var_fct)
+    ad.exhaustive = 1;
+
+
+  mark = (unsigned *) malloc(ad.size * sizeof(unsigned));
+  if (ad.reset_strategy != AD_RESET_RANDOM)
+    {
+      reset_var = (int *) malloc(ad.size * sizeof(int));
+      reset_err = (int *) malloc(ad.size * sizeof(int));
+    }
+  if (ad.exhaustive <= 0)
+    {
+      list_i = (int *) malloc(ad.size * sizeof(int));
+      list_j = (int *) malloc(ad.size * sizeof(int));
+    }
+  else
+    list_ij = (Pair *) malloc(ad.size * sizeof(Pair)); // to run on Cell limit to ad.size instead of ad.size*ad.size
+
+#if defined(DEBUG) && (DEBUG&1)
+  err_var = (int *) malloc(ad.size * sizeof(int));
+  swap = (int *) malloc(ad.size * sizeof(int));
+#endif
+
+  if (mark == NULL || (ad.reset_strategy != AD_RESET_RANDOM && (reset_var == NULL || reset_err == NULL)) ||
+      (!ad.exhaustive && (list_i == NULL || list_j == NULL)) || (ad.exhaustive && list_ij == NULL)
+#if defined(DEBUG) && (DEBUG&1)
+      || err_var == NULL || swap == NULL
+#endif
+      )
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  memset(mark, 0, ad.size * sizeof(unsigned)); /* init with 0 */
+
+  if (ad.log_file)
+    Trace_Open(ad.log_file, ad.size, ad.seed);
+
+  if (ad.stat_interval > 0)
+    Telemetry_Start(ad.size, ad.seed, ad.stat_interval);
+  tele_best_cost = BIG;
+
+  if (ad.landscape)
+    Landscape_Start(ad.size);
+
+  observer = ad.observer;
+  observer_countdown = (observer) ? observer->iter_interval : 0;
+
+  tabu_on = (ad.tabu_window > 0);
+  if (tabu_on)
+    {
+      for(tabu_mask = 63; tabu_mask < 2u * ad.tabu_window; tabu_mask = tabu_mask * 2 + 1)
+	;
+      tabu_hash = (unsigned long long *) malloc((tabu_mask + 1) * sizeof(unsigned long long));
+      tabu_swap = (int *) malloc((tabu_mask + 1) * sizeof(int));
+      if (tabu_hash == NULL || tabu_swap == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+
+  ad.nb_sol_found = ad.nb_sol_dup = 0;
+  if (ad.nb_solutions > 1)
+    {
+      for(sol_mask = 63; sol_mask < 2u * ad.nb_solutions; sol_mask = sol_mask * 2 + 1)
+	;
+      sol_set = (unsigned long long *) calloc(sol_mask + 1, sizeof(unsigned long long));
+      if (sol_set == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+
+  multi_on = (ad.multi_swap > 1 && !ad.exhaustive && !ad_no_footprint_fct);
+  extra_nb = 0;
+  if (multi_on)
+    {
+      var_cost = (int *) malloc(ad.size * sizeof(int));
+      extra_swap = (Pair *) malloc(ad.multi_swap * sizeof(Pair));
+      used_cstr = (int *) malloc(ad.multi_swap * AD_FOOTPRINT_MAX * sizeof(int));
+      if (var_cost == NULL || extra_swap == NULL || used_cstr == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+
+  weight_on = (ad.weight_decay > 0 && ad_weight != NULL && !ad_no_violated_fct);
+  weight_countdown = ad.weight_decay;
+  if (weight_on)
+    {
+      weight_cstr = (int *) malloc(ad_nb_weight * sizeof(int));
+      if (weight_cstr == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+
+				/* any pair is swapped: not if the model restricts them */
+  compound_on = (ad.compound_moves > 0 && ad_no_next_i_fct && ad_no_next_j_fct);
+  endgame_on = (ad.endgame_cost > 0 && ad_no_next_i_fct && ad_no_next_j_fct);
+  if (endgame_on)
+    {
+      endgame_conf = (char *) malloc(ad.size * sizeof(char));
+      if (endgame_conf == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+    }
+
+  verify_on = (ad.verify_interval > 0 || ad.verify_ppm > 0);
+  verify_countdown = ad.verify_interval;
+  verify_rand = (unsigned) ad.seed * 2654435761u | 1;
+
+  ad.nb_restart = -1;
+
+  ad.nb_iter = 0;
+  ad.nb_swap = 0;
+  ad.nb_same_var = 0;
+  ad.nb_reset = 0;
+  ad.nb_local_min = 0;
+
+  ad.nb_iter_tot = 0;
+  ad.nb_swap_tot = 0;
+  ad.nb_same_var_tot = 0;
+  ad.nb_reset_tot = 0;
+  ad.nb_local_min_tot = 0;
+
+  ad.nb_adapt = 0;
+  ad.nb_verify = 0;
+  ad.nb_verify_fail = 0;
+  ad.verify_fail_iter = -1;
+  ad.nb_tabu = 0;
+  ad.nb_extra_swap = 0;
+  ad.nb_compound = 0;
+  ad.nb_weight_raise = 0;
+  ad.nb_endgame = ad.nb_endgame_ok = 0;
+  ad.nb_block_round = 0;
+  ad.nb_block_iter = 0;
+  adapt_init.prob_select_loc_min = ad.prob_select_loc_min;
+  adapt_init.freeze_loc_min = ad.freeze_loc_min;
+  adapt_init.freeze_swap = ad.freeze_swap;
+  adapt_init.reset_limit = ad.reset_limit;
+  adapt_init.nb_var_to_reset = ad.nb_var_to_reset;
+
+#if defined(DEBUG) && (DEBUG&2)
+  if (ad.do_not_init)
+    {
+      printf ("********* received data (do_not_init=1):\n");
+      Ad_Display(ad.sol, &ad, NULL);
+      printf("******************************-\n");
+    }
+#endif
+
+  if (!ad.do_not_init)
+    {
+    restart:
+      ad.nb_iter_tot += ad.nb_iter; 
+      ad.nb_swap_tot += ad.nb_swap; 
+      ad.nb_same_var_tot += ad.nb_same_var;
+      ad.nb_reset_tot += ad.nb_reset;
+      ad.nb_local_min_tot += ad.nb_local_min;
+
+      Random_Permut(ad.sol, ad.size, ad.actual_value, ad.base_value);
+      memset(mark, 0, ad.size * sizeof(unsigned)); /* init with 0 */
+    }
+
+  ad.nb_restart++;
+  ad.nb_iter = 0;
+  ad.nb_swap = 0;
+  endgame_fail_swap = -1;
+  ad.nb_same_var = 0;
+  ad.nb_reset = 0;
+  ad.nb_local_min = 0;
+
+
+  nb_in_plateau = 0;
+
+#if !defined(CELL)
+  if (ad.nb_blocks > 1 && ad.nb_restart == 0 && block_var == NULL)
+    Decompose();		/* first repair the configuration by blocks */
+#endif
+
+  if (tabu_on)			/* new configuration, nb_swap restarts from 0 */
+    {
+      memset(tabu_hash, 0, (tabu_mask + 1) * sizeof(unsigned long long));
+      config_hash = Ad_Hash(ad.sol, ad.size);
+      Tabu_Record(config_hash);
+    }
+
+  if (ad.do_not_init != 2 || ad.nb_restart > 0) /* 2: state already updated by Change_Data */
+    ad.total_cost = Prof_Call(PROF_COST_OF_SOL, Cost_Of_Solution(1));
+  best_cost = ad.total_cost;
+  best_iter = 0;
+
+  if (telemetry_on)
+    Publish_Telemetry(TELE_RUNNING);
+
+  if (ad.kbench_calls > 0)	/* no search: time the user functions */
+    {
+      Ad_Kernel_Bench(&ad);
+      goto end;
+    }
+
+  restart_limit = Restart_Limit();
+  Adapt_Start();
+
+ search:
+  while(ad.total_cost)
+    {
+      ad.nb_iter++;
+
+      if (__builtin_expect(telemetry_on, 0) && --telemetry_countdown <= 0)
+	Publish_Telemetry(TELE_RUNNING);
+
+      if (Observed && observer->on_iteration != NULL && --observer_countdown <= 0)
+	{
+	  observer_countdown = observer->iter_interval;
+	  if (Notify(on_iteration, ad.total_cost))
+	    break;
+	}
+
+#ifdef CELL_COMM
+      int comm_cost = (1 << 30);
+      while(as_mbx_avail())
+	{
+	  int c= as_mbx_read();
+	  if (c < comm_cost)
+	    comm_cost = c;
+	  usleep(1000);
+	}
+      if (1)
+	{
+	  //	  int comm_cost = as_mbx_read();
+#ifdef CELL_COMM_ACTION_CMD
+	  if (ad.total_cost > comm_cost && Random(100) < (unsigned) CELL_COMM_PROB_ACCEPT)
+	    {
+	      int n;
+	      //n = (ad.size - (comm_cost * ad.size / ad.total_cost)) / 10;
 	      n = 50;
 	      if (n < 0 || n > ad.size)
 		//		printf("CELL COMM: received a better cost (%d < %d): reset %d vars !\n", comm_cost, ad.total_cost, n);
@@ -603,25 +1864,48 @@ Ad_Solve(AdData *p_ad)
 #endif
 
 
-      if (ad.nb_iter >= ad.restart_limit)
+      if (ad.nb_iter >= restart_limit ||
+	  (ad.restart_policy == AD_RESTART_STAG && ad.nb_iter - best_iter >= ad.restart_limit))
 	{
 	  if (ad.nb_restart < ad.restart_max)
-	    goto restart;
+	    {
+	      Trace_Event(TR_RESTART, ad.nb_iter, ad.total_cost, ad.nb_restart + 1, best_cost, 0, 0, 0, 0);
+	      if (Observed && Notify(on_restart, ad.nb_restart + 1))
+		break;
+	      goto restart;
+	    }
 	  break;
 	}
 
+      if (ad.adapt_window > 0 && ad.nb_iter % ad.adapt_window == 0)
+	Adapt(nb_in_plateau);
+
       if (!ad.exhaustive)
 	{
-	  Select_Var_High_Cost();
-	  Select_Var_Min_Conflict();
+	  Prof_Call_Void(PROF_SELECT_HIGH_COST, Select_Var_High_Cost());
+	  Prof_Call_Void(PROF_SELECT_MIN_CONFLICT, Select_Var_Min_Conflict());
+	  if (multi_on && new_cost < ad.total_cost)
+	    Select_Extra_Swaps();
 	}
       else
 	{
-	  Select_Vars_To_Swap();
+	  Prof_Call_Void(PROF_SELECT_PAIR, Select_Vars_To_Swap());
+	}
+
+      Trace_Event(TR_ITER, ad.nb_iter, ad.total_cost, new_cost, max_i, min_j,
+		  (ad.exhaustive) ? list_ij_nb : list_i_nb,
+		  (ad.exhaustive) ? 0 : list_j_nb, nb_var_marked);
+
+      if (__builtin_expect(landscape_on, 0))
+	{
+	  Landscape_Add(LAND_TIES_I, (ad.exhaustive) ? list_ij_nb : list_i_nb);
+	  if (!ad.exhaustive)
+	    Landscape_Add(LAND_TIES_J, list_j_nb);
+	  Landscape_Var(max_i);
 	}
 
-      Emit_Log("----- iter no: %d, cost: %d, nb marked: %d ---",
-	       ad.nb_iter, ad.total_cost, nb_var_marked);
+      if (__builtin_expect(verify_on, 0))
+	Shadow_Verify();
 
 #ifdef TRACE
       printf("----- iter no: %d, cost: %d, nb marked: %d --- swap: %d/%d  nb pairs: %d  new cost: %d\n", 
@@ -635,24 +1919,18 @@ Ad_Solve(AdData *p_ad)
       if (ad.total_cost != new_cost)
 	{
 	  if (nb_in_plateau > 1)
-	    {
-	      Emit_Log("\tend of plateau, length: %d", nb_in_plateau);
-	    }
+	    Trace_Event(TR_PLATEAU, ad.nb_iter, ad.total_cost, nb_in_plateau, 0, 0, 0, 0, 0);
+	  if (nb_in_plateau > adapt_plateau)
+	    adapt_plateau = nb_in_plateau;
+	  if (landscape_on)
+	    Landscape_Add(LAND_PLATEAU, nb_in_plateau);
 	  nb_in_plateau = 0;
 	}
 
       if (new_cost < best_cost)
-	best_cost = new_cost;
-
-      if (!ad.exhaustive)
 	{
-	  Emit_Log("\tswap: %d/%d  nb max/min: %d/%d  new cost: %d",
-		   max_i, min_j, list_i_nb, list_j_nb, new_cost);
-	}
-      else
-	{
-	  Emit_Log("\tswap: %d/%d  nb pairs: %d  new cost: %d",
-		   max_i, min_j, list_ij_nb, new_cost);
+	  best_cost = new_cost;
+	  best_iter = ad.nb_iter;
 	}
 
 
@@ -664,7 +1942,7 @@ Ad_Solve(AdData *p_ad)
 #if 0
       if (new_cost >= ad.total_cost && nb_in_plateau > 15)
 	{
-	  Emit_Log("\tTOO BIG PLATEAU - RESET");
+	  Trace_Event(TR_RESET, ad.nb_iter, ad.total_cost, ad.nb_var_to_reset, nb_var_marked, 0, 0, 0, 0);
 	  Reset(ad.nb_var_to_reset);
 	}
 #endif
@@ -675,8 +1953,33 @@ Ad_Solve(AdData *p_ad)
 
       if (max_i == min_j)
 	{
+	  if (compound_on && Try_Compound())
+	    {
+	      if (ad.total_cost < best_cost)
+		{
+		  best_cost = ad.total_cost;
+		  best_iter = ad.nb_iter;
+		}
+	      continue;
+	    }
+
+	  if (endgame_on && ad.total_cost <= ad.endgame_cost && Try_Endgame())
+	    {
+	      if (ad.total_cost < best_cost)
+		{
+		  best_cost = ad.total_cost;
+		  best_iter = ad.nb_iter;
+		}
+	      continue;
+	    }
+
 	  ad.nb_local_min++;
 	  Mark(max_i, ad.freeze_loc_min);
+	  Trace_Event(TR_LOC_MIN, ad.nb_iter, ad.total_cost, max_i, nb_var_marked, 0, 0, 0, 0);
+	  if (landscape_on)
+	    Landscape_Add(LAND_LOC_MIN_COST, ad.total_cost);
+	  if (Observed && Notify(on_local_min, max_i))
+	    break;
 
 #if defined(CELL_COMM) && CELL_COMM_SEND_WHEN == 0
 	  CELL_COMM_SEND_CMD(ad.total_cost);
@@ -684,12 +1987,16 @@ Ad_Solve(AdData *p_ad)
 
 	  if (nb_var_marked + 1 >= ad.reset_limit)
 	    {
-	      Emit_Log("\tTOO MANY FROZEN VARS - RESET");
+	      if (weight_on)
+		Raise_Weights();
+	      Trace_Event(TR_RESET, ad.nb_iter, ad.total_cost, ad.nb_var_to_reset, nb_var_marked, 0, 0, 0, 0);
 
 #if defined(CELL_COMM) && CELL_COMM_SEND_WHEN == 1
 	      CELL_COMM_SEND_CMD(ad.total_cost);
 #endif
-	      Reset(ad.nb_var_to_reset);
+	      Prof_Call_Void(PROF_RESET, Reset(ad.nb_var_to_reset));
+	      if (Observed && Notify(on_reset, ad.nb_var_to_reset))
+		break;
 	    }
 	}
       else
@@ -697,22 +2004,70 @@ Ad_Solve(AdData *p_ad)
 	  Mark(max_i, ad.freeze_swap);
 	  Mark(min_j, ad.freeze_swap);
 	  Swap(max_i, min_j);
-	  Executed_Swap(max_i, min_j);
+	  Prof_Call_Void(PROF_EXEC_SWAP, Executed_Swap(max_i, min_j));
 	  ad.total_cost = new_cost;
+
+	  if (extra_nb > 0)	/* multi_on: other independent swaps */
+	    {
+	      Multi_Swap();
+	      if (ad.total_cost < best_cost)
+		{
+		  best_cost = ad.total_cost;
+		  best_iter = ad.nb_iter;
+		}
+	    }
+
+	  if (Observed && best_iter == ad.nb_iter && Notify(on_improvement, best_cost))
+	    break;
 	}
     }
 
-#ifdef LOG_FILE
-  if (f_log)
-    fclose(f_log);
-#endif
+  if (ad.total_cost == 0 && ad.nb_solutions > 1)
+    {
+      if (Record_Solution())	/* diversify and search the next one */
+	{
+	  Prof_Call_Void(PROF_RESET, Reset(ad.nb_var_to_reset));
+	  goto search;
+	}
+    }
+  else if (Observed && ad.total_cost == 0)
+    (void) Notify(on_solution, 1);
+
+ end:
+  Trace_Event(TR_END, ad.nb_iter, ad.total_cost, ad.nb_restart, 0, 0, 0, 0, 0);
+  Trace_Close();
+
+  if (telemetry_on)
+    Publish_Telemetry((ad.total_cost) ? TELE_UNSOLVED : TELE_SOLVED);
 
   free(mark);
+  if (ad.reset_strategy != AD_RESET_RANDOM)
+    {
+      free(reset_var);
+      free(reset_err);
+    }
   free(list_i);
   if (!ad.exhaustive)
     free(list_j);
   else
     free(list_ij);
+  if (tabu_on)
+    {
+      free(tabu_hash);
+      free(tabu_swap);
+    }
+  if (ad.nb_solutions > 1)
+    free(sol_set);
+  if (weight_on)
+    free(weight_cstr);
+  if (endgame_on)
+    free(endgame_conf);
+  if (multi_on)
+    {
+      free(var_cost);
+      free(extra_swap);
+      free(used_cstr);
+    }
 
 #if defined(DEBUG) && (DEBUG&1)
   free(err_var);
@@ -726,12 +2081,87 @@ Ad_Solve(AdData *p_ad)
   ad.nb_reset_tot += ad.nb_reset;
   ad.nb_local_min_tot += ad.nb_local_min;
 
+  ad.prob_select_loc_min = adapt_init.prob_select_loc_min; /* inputs: undo adaptations */
+  ad.freeze_loc_min = adapt_init.freeze_loc_min;
+  ad.freeze_swap = adapt_init.freeze_swap;
+  ad.reset_limit = adapt_init.reset_limit;
+  ad.nb_var_to_reset = adapt_init.nb_var_to_reset;
+
   *p_ad = ad;
+
+  Prof_End(PROF_SOLVE, prof_solve_t0);
   return ad.total_cost;
 }
 
 
 
+#if defined(PROF) && PROF
+/*
+ *  AD_PROF_DISPLAY
+ *
+ *  Displays the profiling counters (cumulated over all resolutions).
+ *  The engine phases include the user functions they call, the remaining
+ *  time of Ad_Solve (marks, swaps, logs,...) is shown as "engine: other".
+ */
+void
+Ad_Prof_Display(void)
+{
+  static char *name[PROF_NB] =
+    {
+      "Cost_Of_Solution",
+      "Cost_Of_Solution (Reset)",
+      "Cost_Of_Solution (no_cost_swap)",
+      "Cost_On_Variable",
+      "Cost_If_Swap",
+      "Executed_Swap",
+      "Next_I",
+      "Next_J",
+      "engine: Select_Var_High_Cost",
+      "engine: Select_Var_Min_Conflict",
+      "engine: Select_Vars_To_Swap",
+      "engine: Reset",
+      "engine: Ad_Solve",
+    };
+  ProfTime total = ad_prof[PROF_SOLVE].time;
+  ProfTime other = total;
+  int k;
+
+  if (total == 0)
+    total = 1;
+
+  printf("\nprofile (%s)\n", PROF_UNIT);
+  printf("%-34s %12s %16s %12s %7s\n", "", "calls", "total", "per call", "% solve");
+
+  for(k = 0; k < PROF_NB; k++)
+    {
+      if (ad_prof[k].nb_call == 0)
+	continue;
+
+      printf("%-34s %12lld %16llu %12.1f %7.2f\n", name[k], ad_prof[k].nb_call,
+	     ad_prof[k].time, (double) ad_prof[k].time / ad_prof[k].nb_call,
+	     100.0 * ad_prof[k].time / total);
+
+      switch(k)			/* top-level parts of Ad_Solve */
+	{
+	case PROF_COST_OF_SOL:
+	case PROF_EXEC_SWAP:
+	case PROF_SELECT_HIGH_COST:
+	case PROF_SELECT_MIN_CONFLICT:
+	case PROF_SELECT_PAIR:
+	case PROF_RESET:
+	  other -= ad_prof[k].time;
+	}
+    }
+
+  if (other <= ad_prof[PROF_SOLVE].time)
+    printf("%-34s %12s %16llu %12s %7.2f\n", "engine: other", "",
+	   other, "", 100.0 * other / total);
+}
+#endif
+
+
+
+
 /*
  *  AD_DISPLAY
  *
@@ -771,6 +2201,28 @@ Ad_Display(int *t, AdData *p_ad, unsigned *mark)
 
 
 
+/*
+ *  AD_HASH
+ *
+ *  Returns the Zobrist hash of a configuration (as maintained by the
+ *  engine with tabu_window), e.g. to detect identical configurations or
+ *  solutions across runs/processes.
+ */
+unsigned long long
+Ad_Hash(int *sol, int size)
+{
+  unsigned long long h = 0;
+  int i;
+
+  for(i = 0; i < size; i++)
+    h ^= Zobrist(i, sol[i]);
+
+  return h;
+}
+
+
+
+
 /*
  *  SHOW_DEBUG_INFO
  *
@@ -23,6 +23,19 @@
  * Constants *
  *-----------*/
 
+				/* restart policies (restart_policy) */
+#define AD_RESTART_FIXED     0	/* restart after restart_limit iters */
+#define AD_RESTART_LUBY      1	/* restart after restart_limit * luby(k) iters */
+#define AD_RESTART_GEOM      2	/* restart after restart_limit * (restart_factor/100)^k iters */
+#define AD_RESTART_STAG      3	/* restart after restart_limit iters without improvement */
+
+				/* reset strategies (reset_strategy) */
+#define AD_RESET_RANDOM      0	/* nb_var_to_reset random swaps, recompute the cost, unmark all */
+#define AD_RESET_WORST       1	/* swap the nb_var_to_reset vars of highest cost with random vars */
+#define AD_RESET_FROZEN      2	/* swap the marked (frozen) vars with random vars */
+
+#define AD_FOOTPRINT_MAX     16	/* max nb of constraints returned by Swap_Footprint */
+
 /*-------*
  * Types *
  *-------*/
@@ -32,7 +45,8 @@ typedef struct
 				/* --- input: basic data --- */
 
   int size;			/* nb of variables */
-  int do_not_init;		/* use the initial solution (else random permut) */
+  int do_not_init;		/* use the initial solution (else random permut), 2: also the
+				 * state of the model and total_cost (see Change_Data) */
   int *actual_value;		/* if random permut: actual values (see tools.c) */
   int base_value;		/* if random permut: base value (see tools.c) */
   int debug;			/* debug level (0 1 2) */
@@ -48,9 +62,29 @@ typedef struct
   int freeze_swap;		/* nb swaps to freeze 2 swapped vars */
   int reset_limit;		/* nb of frozen vars before reset */
   int nb_var_to_reset;		/* nb variables to reset */
+  int reset_strategy;		/* which variables are reset (AD_RESET_...) */
+  int tabu_window;		/* refuse non-improving moves back to a configuration seen in the last NB swaps (0=none) */
+  int multi_swap;		/* >1: up to NB non-interacting improving swaps per iter (see Swap_Footprint) */
+  int compound_moves;		/* on a local min try the 3-cycles of max_i with NB partners (0=none) */
+  int weight_decay;		/* >0: raise the weights of the violated constraints at each reset
+				 * and halve them every NB raises (see Ad_Weight_Init), 0=none */
+  int endgame_cost;		/* on a local min of cost <= NB try a bounded DFS over the swaps
+				 * of the conflicting vars (0=none) */
+  int nb_solutions;		/* >1: go on after a solution until NB distinct ones are found */
   int restart_limit;		/* nb of iterations before restart */
   int restart_max;		/* max nb of times to restart (to retry) */
+  int restart_policy;		/* when to restart (AD_RESTART_...) */
+  int restart_factor;		/* growth (in %) of the restart limit (AD_RESTART_GEOM) */
   int reinit_after_if_swap;	/* true if Cost_Of_Solution must be called twice */
+  int adapt_window;		/* nb of iters between 2 adaptations of the above parameters (0=none) */
+  int kbench_calls;		/* >0: only time the user functions (nb of calls), see kbench.c */
+  int stat_interval;		/* publish a live status every NB iters (0=none), see telemetry.h */
+  int landscape;		/* record the distributions of the landscape, see landscape.h */
+  int verify_interval;		/* check the incremental costs every NB iters (0=none) */
+  int verify_ppm;		/* else check them with this probability (per million, 0=none) */
+  struct ad_observer *observer;	/* hooks called on engine events or NULL (see AdObserver) */
+  int nb_blocks;		/* >1: first repair the configuration by rounds of NB disjoint
+				 * blocks searched in parallel (one process each) */
 
 				/* --- input / output: solution --- */
 
@@ -75,6 +109,26 @@ typedef struct
   int nb_reset_tot;		/* nb of resets total */
   int nb_local_min_tot;		/* nb of local mins total */
 
+  int nb_adapt;			/* nb of parameter adaptations (all restarts) */
+
+  int nb_verify;		/* nb of shadow verifications (all restarts) */
+  int nb_verify_fail;		/* nb of verifications which found a divergence */
+  int verify_fail_iter;		/* iter (all restarts) of the first divergence (-1 if none) */
+
+  int nb_tabu;			/* nb of moves refused by tabu_window (all restarts) */
+
+  int nb_extra_swap;		/* nb of swaps done in addition to max_i/min_j (multi_swap > 1) */
+  int nb_compound;		/* nb of local mins escaped by a 3-cycle (compound_moves > 0) */
+  int nb_weight_raise;		/* nb of times the weights were raised (weight_decay > 0) */
+  int nb_endgame;		/* nb of endgame searches (endgame_cost > 0) */
+  int nb_endgame_ok;		/* nb of them which found a solution */
+
+  int nb_sol_found;		/* nb of distinct solutions found (nb_solutions > 1) */
+  int nb_sol_dup;		/* nb of solutions found again */
+
+  int nb_block_round;		/* nb of rounds of the decomposition (nb_blocks > 1) */
+  int nb_block_iter;		/* nb of iterations of the block searches (all blocks) */
+
 
 				/* --- other values (e.g. from main) not used the solver engine --- */
 
@@ -87,15 +141,46 @@ typedef struct
 } AdData;
 
 
+				/* a hook receives the current data of the engine, a value
+				 * depending on the event and the data of the observer.
+				 * Returning non-zero stops the search (as if the limits
+				 * were reached, with nb_solutions: stops enumerating). */
+
+typedef int (*AdHook)(AdData *p_ad, int value, void *data);
+
+typedef struct ad_observer
+{
+  AdHook on_iteration;		/* every iter_interval iters: value=current cost */
+  AdHook on_local_min;		/* value=variable of the local min */
+  AdHook on_reset;		/* after a reset: value=nb of variables reset */
+  AdHook on_restart;		/* before a restart: value=no of the new restart */
+  AdHook on_improvement;	/* after a swap giving a new best cost: value=best cost */
+  AdHook on_solution;		/* a (new) solution: value=nb of distinct solutions so far */
+  int iter_interval;		/* nb of iters between 2 calls of on_iteration */
+  void *data;			/* passed to the hooks */
+}AdObserver;
+
+
 /*------------------*
  * Global variables *
  *------------------*/
 
 int *ad_sol ALIGN;		/* copy of p_ad->sol (used by no_cost_swap) */
+
+int *ad_weight;			/* weight of each constraint (benches calling Ad_Weight_Init) */
+int ad_nb_weight;		/* nb of weighted constraints */
 int ad_reinit_after_if_swap;	/* copy of p_ad->reinit_after_if_swap (used by no_cost_swap) */
 
 int ad_no_cost_var_fct;		/* true if a user Cost_On_Variable is not defined */
 int ad_no_displ_sol_fct;	/* true if a user Display_Sol is not defined */
+int ad_no_cost_swap_fct;	/* true if a user Cost_If_Swap is not defined */
+int ad_no_exec_swap_fct;	/* true if a user Executed_Swap is not defined */
+int ad_no_next_i_fct;		/* true if a user Next_I is not defined */
+int ad_no_next_j_fct;		/* true if a user Next_J is not defined */
+int ad_no_change_data_fct;	/* true if a user Change_Data is not defined */
+int ad_no_footprint_fct;	/* true if a user Swap_Footprint is not defined */
+int ad_no_cost_cycle_fct;	/* true if a user Cost_If_Cycle is not defined */
+int ad_no_violated_fct;		/* true if a user Violated_Constraints is not defined */
 
 
 
@@ -106,7 +191,7 @@ int ad_has_debug;
 #endif
 
 
-#if defined(AD_SOLVER_FILE) && defined(LOG_FILE)
+#if defined(AD_SOLVER_FILE) && !defined(CELL)
 int ad_has_log_file = 1;
 #else
 int ad_has_log_file;
@@ -121,6 +206,16 @@ int Ad_Solve(AdData *p_ad);
 
 void Ad_Display(int *t, AdData *p_ad, unsigned *mark);
 
+unsigned long long Ad_Hash(int *sol, int size);
+
+void Ad_Weight_Init(int nb_cstr);
+
+#if !defined(CELL)
+void Ad_Kernel_Bench(AdData *p_ad);
+#else
+#define Ad_Kernel_Bench(p_ad)
+#endif
+
 							/* functions provided by the user */
 
 int Cost_Of_Solution(int should_be_recorded);		/* mandatory */
@@ -137,4 +232,12 @@ int Next_J(int i, int j);				/* optional else from i+1 to p_ad->size-1 */
 
 void Display_Solution(AdData *p_ad);			/* optional else basic display */
 
+int Change_Data(char *change, AdData *p_ad);		/* optional (live changes of the data) */
+
+int Swap_Footprint(int i, int j, int *cstr);		/* optional (constraints changed by a swap) */
+
+int Cost_If_Cycle(int current_cost, int i, int j, int k); /* optional (cost after swapping i/j then i/k) */
+
+int Violated_Constraints(int *cstr);			/* optional (with Ad_Weight_Init: weighting) */
+
 #endif /* !AD_SOLVER_H */
@@ -0,0 +1,260 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  adstat.c: displays the live status of running solvers (see telemetry.h)
+ *
+ *  Usage: adstat [-i SECS] [-1] [PID]
+ *    without PID   list the processes publishing a status (option -M)
+ *                  and remove the blocks left by killed processes
+ *    -i SECS       display interval (default 1)
+ *    -1            display only once
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/mman.h>
+
+#include "telemetry.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define SHM_DIR              "/dev/shm"
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static char *state_name[] = TELE_STATE_NAMES;
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static AdTelemetry *Attach(int pid);
+
+static void Read_Status(AdTelemetry *t, AdTelemetry *v);
+
+static void Display_Status(AdTelemetry *v, int with_pid);
+
+static int List(void);
+
+
+
+
+/*
+ *  MAIN
+ *
+ */
+int
+main(int argc, char *argv[])
+{
+  AdTelemetry *t, v;
+  double interval = 1;
+  int once = 0, pid = 0;
+  int i, nb = 0;
+
+  for(i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+	interval = atof(argv[++i]);
+      else if (strcmp(argv[i], "-1") == 0)
+	once = 1;
+      else if (argv[i][0] != '-' && pid == 0)
+	pid = atoi(argv[i]);
+      else
+	{
+	  fprintf(stderr, "Usage: %s [-i SECS] [-1] [PID]\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  if (pid <= 0)
+    return List();
+
+  if ((t = Attach(pid)) == NULL)
+    {
+      fprintf(stderr, "no status published by process %d (option -M)\n", pid);
+      return 1;
+    }
+
+  for(;;)
+    {
+      Read_Status(t, &v);
+      if (nb++ % 20 == 0)
+	Display_Status(NULL, 0);
+      Display_Status(&v, 0);
+
+      if (once)
+	break;
+
+      if (kill(pid, 0) < 0 && errno == ESRCH)
+	{
+	  printf("process %d has terminated\n", pid);
+	  break;
+	}
+
+      usleep((useconds_t) (interval * 1000000));
+    }
+
+  return 0;
+}
+
+
+
+
+/*
+ *  ATTACH
+ *
+ *  Maps the status block of process pid (NULL if none).
+ */
+static AdTelemetry *
+Attach(int pid)
+{
+  char name[32];
+  AdTelemetry *t;
+  int fd;
+
+  sprintf(name, "%s%d", TELEMETRY_PREFIX, pid);
+  if ((fd = shm_open(name, O_RDONLY, 0)) < 0)
+    return NULL;
+
+  t = (AdTelemetry *) mmap(NULL, sizeof(AdTelemetry), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (t == MAP_FAILED)
+    return NULL;
+
+  if (strcmp(t->magic, TELEMETRY_MAGIC) != 0 || t->version != TELEMETRY_VERSION)
+    {
+      fprintf(stderr, "%s: not a status block (or another version)\n", name);
+      munmap(t, sizeof(AdTelemetry));
+      return NULL;
+    }
+
+  return t;
+}
+
+
+
+
+/*
+ *  READ_STATUS
+ *
+ *  Copies a consistent version of the block (seqlock reader).
+ */
+static void
+Read_Status(AdTelemetry *t, AdTelemetry *v)
+{
+  unsigned seq;
+
+  for(;;)
+    {
+      seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+      if (seq & 1)
+	continue;
+
+      memcpy(v, t, sizeof(AdTelemetry));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+      if (__atomic_load_n(&t->seq, __ATOMIC_RELAXED) == seq)
+	break;
+    }
+}
+
+
+
+
+/*
+ *  DISPLAY_STATUS
+ *
+ *  Displays a status line (the header if v is NULL).
+ */
+static void
+Display_Status(AdTelemetry *v, int with_pid)
+{
+  if (v == NULL)
+    {
+      if (with_pid)
+	printf("%7s ", "pid");
+      printf("%9s %4s %-8s %10s %10s %12s %10s %6s %6s %8s %6s\n", "elapsed", "run", "state",
+	     "cost", "best", "iters", "iters/s", "restart", "resets", "loc_min", "marked");
+      return;
+    }
+
+  if (with_pid)
+    printf("%7d ", v->pid);
+  printf("%9.2f %4d %-8s %10d %10d %12lld %10.0f %6d %6d %8d %6d\n", v->elapsed, v->run,
+	 ((unsigned) v->state < TELE_NB_STATE) ? state_name[v->state] : "?",
+	 v->cost, v->best_cost, v->nb_iter_tot, v->iter_per_sec, v->nb_restart,
+	 v->nb_reset, v->nb_local_min, v->nb_marked);
+}
+
+
+
+
+/*
+ *  LIST
+ *
+ *  Displays the status of all processes publishing one.
+ */
+static int
+List(void)
+{
+  DIR *dir;
+  struct dirent *e;
+  AdTelemetry *t, v;
+  char *prefix = TELEMETRY_PREFIX + 1;	/* without the / */
+  char name[32];
+  int pid, nb = 0;
+
+  if ((dir = opendir(SHM_DIR)) == NULL)
+    {
+      perror(SHM_DIR);
+      return 1;
+    }
+
+  while((e = readdir(dir)) != NULL)
+    {
+      if (strncmp(e->d_name, prefix, strlen(prefix)) != 0)
+	continue;
+
+      pid = atoi(e->d_name + strlen(prefix));
+      if (kill(pid, 0) < 0 && errno == ESRCH)
+	{
+	  sprintf(name, "%s%d", TELEMETRY_PREFIX, pid);
+	  shm_unlink(name);
+	  continue;
+	}
+
+      if ((t = Attach(pid)) == NULL)
+	continue;
+
+      Read_Status(t, &v);
+      if (nb++ == 0)
+	Display_Status(NULL, 1);
+      Display_Status(&v, 1);
+      munmap(t, sizeof(AdTelemetry));
+    }
+  closedir(dir);
+
+  if (nb == 0)
+    printf("no running solver publishes its status (option -M)\n");
+
+  return 0;
+}
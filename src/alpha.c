@@ -121,6 +121,8 @@ static XRef xref[NB_VAR][NB_CSTR];
  *                NB_CSTR-1
  *  The total cost = Sum | err[j] |
  *                   j=0
+ *  (each term multiplied by the weight of the equation, 1 unless the
+ *  engine raises them, see weight_decay)
  *
  *  The projection on a variable i
  *
@@ -184,6 +186,8 @@ Solve(AdData *p_ad)
 #endif
     }
 
+  Ad_Weight_Init(NB_CSTR);
+
   Ad_Solve(p_ad);
 }
 
@@ -213,7 +217,7 @@ Cost_Of_Solution(int should_be_recorded)
 
       if (should_be_recorded)
 	err[j] = er;
-      r += abs(er);
+      r += ad_weight[j] * abs(er);
     }
 
 #if 0
@@ -245,7 +249,7 @@ Cost_On_Variable(int i)
 
 #if 1
   for(q = xref[i]; (t = q->times) != 0 ; q++)
-    r += t * *(q->err);
+    r += t * ad_weight[q->err - err] * *(q->err);
 #else
   for(q = xref[i]; (t = q->times) != 0 ; q++)
     {
@@ -266,7 +270,7 @@ Cost_On_Variable(int i)
  *  Evaluates the new total cost for a swap.
  */
 
-#define Adjust(r, diff, x)   r = r - abs(x) + abs(x + (diff))
+#define Adjust(r, diff, er)  r += ad_weight[(er) - err] * (abs(*(er) + (diff)) - abs(*(er)))
 
 int
 Cost_If_Swap(int current_cost, int i1, int i2)
@@ -291,21 +295,21 @@ Cost_If_Swap(int current_cost, int i1, int i2)
 
       if (er1 < er2)
 	{
-	  Adjust(r, diff1 * t1, *er1);
+	  Adjust(r, diff1 * t1, er1);
 	  q1++;
 	}
       else if (er2 < er1)
 	{
-	  Adjust(r, diff2 * t2, *er2);
+	  Adjust(r, diff2 * t2, er2);
 	  q2++;
 	}
       else
 	{
 	  t1 -= t2;
 	  if (t1 > 0)
-	    Adjust(r, diff1 * t1, *er1);
+	    Adjust(r, diff1 * t1, er1);
 	  else
-	    Adjust(r, diff2 * -t1, *er2);	    
+	    Adjust(r, diff2 * -t1, er2);	    
 	  q1++;
 	  q2++;
 	}
@@ -314,14 +318,14 @@ Cost_If_Swap(int current_cost, int i1, int i2)
   while((t1 = q1->times) != 0)
     {
       er1 = q1->err;
-      Adjust(r, diff1 * t1, *er1);
+      Adjust(r, diff1 * t1, er1);
       q1++;
     }
 
   while((t2 = q2->times) != 0)
     {
       er2 = q2->err;
-      Adjust(r, diff2 * t2, *er2);
+      Adjust(r, diff2 * t2, er2);
       q2++;
     }
 
@@ -401,6 +405,73 @@ Init_Parameters(AdData *p_ad)
 
 
 
+/*
+ *  CHANGE_DATA
+ *
+ *  Changes the value of an equation: "WORD VALUE" or "EQUATION_NO VALUE"
+ *  (from 1). Only err[] of this equation is updated. Returns the new total
+ *  cost (or -1 if the change is invalid), summed from err[] with all weights
+ *  back to 1 (as Solve sets them), since a -y search may have raised them.
+ */
+
+int
+Change_Data(char *change, AdData *p_ad)
+{
+  char word[32];
+  int value, j, k, r;
+  int *p;
+
+  if (sscanf(change, "%31s %d", word, &value) != 2)
+    return -1;
+
+  if (*word >= '0' && *word <= '9')
+    j = atoi(word) - 1;
+  else
+    for(j = 0; j < NB_CSTR; j++)
+      {
+	for(p = cstr[j].left, k = 0; *p >= 0 && (word[k] & ~0x20) == 'A' + *p; p++, k++)
+	  ;
+	if (*p < 0 && word[k] == '\0')
+	  break;
+      }
+
+  if (j < 0 || j >= NB_CSTR)
+    return -1;
+
+  err[j] += cstr[j].right - value;
+  cstr[j].right = value;
+
+  Ad_Weight_Init(NB_CSTR);
+  for(j = 0, r = 0; j < NB_CSTR; j++)
+    r += abs(err[j]);
+
+  return r;
+}
+
+
+
+
+/*
+ *  VIOLATED_CONSTRAINTS
+ *
+ *  The equations not satisfied.
+ */
+
+int
+Violated_Constraints(int *cstr)
+{
+  int j, n = 0;
+
+  for(j = 0; j < NB_CSTR; j++)
+    if (err[j])
+      cstr[n++] = j;
+
+  return n;
+}
+
+
+
+
 /*
  *  CHECK_SOLUTION
  *
@@ -0,0 +1,181 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  hwcount.c: hardware performance counters (Linux perf_event_open)
+ *
+ *  The counters form a group (led by the first one which can be opened) so
+ *  they are scheduled together. They are opened at the first Hw_Start of
+ *  a process (a worker forked by multi.c opens its own). If the kernel
+ *  multiplexes them the values are scaled.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hwcount.h"
+
+#if defined(__linux__) && !defined(CELL)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static int hw_warned;		/* warning already displayed */
+
+#if defined(__linux__) && !defined(CELL)
+
+static int hw_pid;		/* process which opened the counters (0=none) */
+static int hw_fd[HW_NB];	/* fd of each counter (-1 if not available) */
+static int hw_leader = -1;	/* fd of the group leader (-1 if none) */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static int Open_Counters(void);
+
+
+
+
+/*
+ *  OPEN_COUNTERS
+ *
+ *  Returns the nb of counters opened.
+ */
+static int
+Open_Counters(void)
+{
+  static unsigned long long config[HW_NB] =
+    {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+  struct perf_event_attr attr;
+  int k, nb = 0;
+
+  if (hw_pid != 0)		/* counters of the parent process */
+    for(k = 0; k < HW_NB; k++)
+      if (hw_fd[k] >= 0)
+	close(hw_fd[k]);
+
+  hw_pid = getpid();
+  hw_leader = -1;
+
+  for(k = 0; k < HW_NB; k++)
+    {
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config[k];
+      attr.disabled = (hw_leader < 0);	/* the leader starts/stops the group */
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      hw_fd[k] = syscall(__NR_perf_event_open, &attr, 0, -1, hw_leader, 0);
+      if (hw_fd[k] < 0)
+	continue;
+
+      if (hw_leader < 0)
+	hw_leader = hw_fd[k];
+      nb++;
+    }
+
+  return nb;
+}
+
+
+
+
+/*
+ *  HW_START
+ *
+ *  Resets and starts the counters. Returns 0 if no counter is available.
+ */
+int
+Hw_Start(void)
+{
+  if (hw_pid != getpid() && Open_Counters() == 0 && !hw_warned)
+    {
+      hw_warned = 1;
+      perror("warning: hardware counters not available (see /proc/sys/kernel/perf_event_paranoid)");
+    }
+
+  if (hw_leader < 0)
+    return 0;
+
+  ioctl(hw_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(hw_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return 1;
+}
+
+
+
+
+/*
+ *  HW_STOP
+ *
+ *  Stops the counters and stores their values in v (-1 if not available).
+ */
+void
+Hw_Stop(long long *v)
+{
+  unsigned long long r[3];	/* value, time enabled, time running */
+  int k;
+
+  if (hw_leader >= 0)
+    ioctl(hw_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  for(k = 0; k < HW_NB; k++)
+    {
+      v[k] = -1;
+      if (hw_leader < 0 || hw_fd[k] < 0 || read(hw_fd[k], r, sizeof(r)) != sizeof(r) || r[2] == 0)
+	continue;
+
+      v[k] = (r[2] < r[1]) ? (long long) ((double) r[0] * r[1] / r[2]) : (long long) r[0];
+    }
+}
+
+#else  /* no perf_event_open */
+
+int
+Hw_Start(void)
+{
+  if (!hw_warned)
+    {
+      hw_warned = 1;
+      fprintf(stderr, "warning: hardware counters not available on this system\n");
+    }
+  return 0;
+}
+
+
+void
+Hw_Stop(long long *v)
+{
+  int k;
+
+  for(k = 0; k < HW_NB; k++)
+    v[k] = -1;
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  hwcount.h: hardware performance counters (Linux perf_event_open)
+ *
+ *  Counts (user mode only) the cycles, instructions, last level cache misses
+ *  and branch misses of the calling process between Hw_Start and Hw_Stop.
+ *  If the kernel (or the machine) does not allow a counter its value is -1,
+ *  if none is available Hw_Start returns 0 (with a warning the first time).
+ */
+
+#ifndef HWCOUNT_H
+#define HWCOUNT_H 1
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+enum
+{
+  HW_CYCLES,
+  HW_INSTRUCTIONS,
+  HW_LLC_MISSES,
+  HW_BRANCH_MISSES,
+  HW_NB
+};
+
+#define HW_NAMES  { "cycles", "instructions", "llc_misses", "branch_misses" }
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+int Hw_Start(void);
+
+void Hw_Stop(long long *v);
+
+#endif /* !HWCOUNT_H */
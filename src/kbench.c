@@ -0,0 +1,282 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  kbench.c: microbenchmark of the user functions (cost kernels)
+ *
+ *  Called by Ad_Solve instead of the search when kbench_calls > 0, once the
+ *  model is initialized on a random configuration. Each function is timed
+ *  in isolation on random variables / pairs (drawn before the timing) in
+ *  NB_BATCH batches, giving a mean time per call and its std deviation
+ *  which do not depend on the search trajectory. In exhaustive mode the
+ *  pairs are sampled among the ones given by Next_I / Next_J (a model can
+ *  restrict its neighborhood, e.g. partit).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ad_solver.h"
+#include "tools.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define NB_BATCH             10
+#define NB_PAIR              (1 << 16) /* random pairs (power of 2) */
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef struct
+{
+  int i, j;			/* i < j */
+}KPair;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static KPair *pair;
+static volatile int sink;	/* results of the calls (not optimized away) */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Draw_Pairs(AdData *p_ad);
+
+static double Clock_Ns(void);
+
+static void Display(char *name, char *note, long long nb_call, double *t);
+
+
+
+
+/*
+ *  AD_KERNEL_BENCH
+ *
+ *  Times the user functions on the current (random) configuration.
+ *  Cost_If_Swap and Cost_On_Variable do not modify it, Executed_Swap is
+ *  timed on real swaps (so the configuration remains random).
+ */
+void
+Ad_Kernel_Bench(AdData *p_ad)
+{
+  long long nb_call = p_ad->kbench_calls;
+  long long nb_full;		/* calls of the functions in O(size) or more */
+  long long n, b, k;
+  double t[NB_BATCH], t0;
+  int size = p_ad->size;
+  int *sol = p_ad->sol;
+  int cost = p_ad->total_cost;
+  KPair *p;
+  int x, s = 0;
+
+  if (size < 2)
+    return;
+
+  Draw_Pairs(p_ad);
+
+  nb_full = nb_call / size;
+  if (nb_full < NB_BATCH)
+    nb_full = NB_BATCH;
+
+  n = nb_call / NB_BATCH;
+  if (n <= 0)
+    n = 1;
+
+  printf("kernel benchmark: %d variables, initial cost: %d, %lld calls in %d batches\n",
+	 size, cost, n * NB_BATCH, NB_BATCH);
+  printf("%-18s %-12s %12s %12s %12s %12s\n", "function", "", "calls", "ns/call", "std dev", "min");
+
+
+  for(b = 0; b < NB_BATCH; b++)	/* Cost_If_Swap */
+    {
+      long long m = (ad_no_cost_swap_fct) ? nb_full / NB_BATCH : n;
+
+      t0 = Clock_Ns();
+      for(k = 0; k < m; k++)
+	{
+	  p = pair + (k & (NB_PAIR - 1));
+	  s += Cost_If_Swap(cost, p->i, p->j);
+	}
+      t[b] = (Clock_Ns() - t0) / m;
+    }
+  Display("Cost_If_Swap", (ad_no_cost_swap_fct) ? "(default)" : "",
+	  ((ad_no_cost_swap_fct) ? nb_full / NB_BATCH : n) * NB_BATCH, t);
+
+
+  if (!ad_no_cost_var_fct)	/* Cost_On_Variable */
+    {
+      for(b = 0; b < NB_BATCH; b++)
+	{
+	  t0 = Clock_Ns();
+	  for(k = 0; k < n; k++)
+	    s += Cost_On_Variable(pair[k & (NB_PAIR - 1)].j);
+	  t[b] = (Clock_Ns() - t0) / n;
+	}
+      Display("Cost_On_Variable", "", n * NB_BATCH, t);
+    }
+  else
+    printf("%-18s %s\n", "Cost_On_Variable", "(undefined)");
+
+
+  if (!ad_no_exec_swap_fct)	/* Executed_Swap (with the swap itself) */
+    {
+      for(b = 0; b < NB_BATCH; b++)
+	{
+	  t0 = Clock_Ns();
+	  for(k = 0; k < n; k++)
+	    {
+	      p = pair + (k & (NB_PAIR - 1));
+	      x = sol[p->i];
+	      sol[p->i] = sol[p->j];
+	      sol[p->j] = x;
+	      Executed_Swap(p->i, p->j);
+	    }
+	  t[b] = (Clock_Ns() - t0) / n;
+	}
+      Display("Executed_Swap", "", n * NB_BATCH, t);
+    }
+  else
+    printf("%-18s %s\n", "Executed_Swap", "(undefined)");
+
+
+  for(b = 0; b < NB_BATCH; b++)	/* Cost_Of_Solution */
+    {
+      long long m = nb_full / NB_BATCH;
+
+      t0 = Clock_Ns();
+      for(k = 0; k < m; k++)
+	s += Cost_Of_Solution(1);
+      t[b] = (Clock_Ns() - t0) / m;
+    }
+  Display("Cost_Of_Solution", "", nb_full / NB_BATCH * NB_BATCH, t);
+
+  sink = s;
+  p_ad->total_cost = Cost_Of_Solution(1);
+
+  free(pair);
+}
+
+
+
+
+/*
+ *  DRAW_PAIRS
+ *
+ *  Fills pair[] with NB_PAIR random pairs i < j. In exhaustive mode they
+ *  are drawn (reservoir sampling) among the pairs enumerated by the engine.
+ */
+static void
+Draw_Pairs(AdData *p_ad)
+{
+  int size = p_ad->size;
+  unsigned nb = 0, r;
+  KPair *p;
+  int i, j, k;
+
+  if ((pair = (KPair *) malloc(NB_PAIR * sizeof(KPair))) == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  if (p_ad->exhaustive <= 0)
+    {
+      for(k = 0; k < NB_PAIR; k++)
+	{
+	  p = pair + k;
+	  p->i = Random(size);
+	  while((p->j = Random(size)) == p->i)
+	    ;
+	  if (p->i > p->j)
+	    {
+	      i = p->i;
+	      p->i = p->j;
+	      p->j = i;
+	    }
+	}
+      return;
+    }
+
+  i = -1;
+  while((unsigned) (i = Next_I(i)) < (unsigned) size)
+    {
+      j = -1;
+      while((unsigned) (j = Next_J(i, j)) < (unsigned) size)
+	{
+	  r = (nb < NB_PAIR) ? nb : Random(nb + 1);
+	  nb++;
+	  if (r < NB_PAIR)
+	    {
+	      pair[r].i = i;
+	      pair[r].j = j;
+	    }
+	}
+    }
+
+  if (nb == 0)
+    {
+      fprintf(stderr, "kernel benchmark: no pair to swap\n");
+      exit(1);
+    }
+
+  for(k = nb; k < NB_PAIR; k++)	/* few pairs: repeat them */
+    pair[k] = pair[Random(nb)];
+}
+
+
+
+
+/*
+ *  CLOCK_NS
+ *
+ */
+static double
+Clock_Ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+
+
+/*
+ *  DISPLAY
+ *
+ *  Displays the mean, std deviation and min of the times of the batches.
+ */
+static void
+Display(char *name, char *note, long long nb_call, double *t)
+{
+  double mean = 0, var = 0, min = t[0];
+  int b;
+
+  for(b = 0; b < NB_BATCH; b++)
+    {
+      mean += t[b];
+      if (t[b] < min)
+	min = t[b];
+    }
+  mean /= NB_BATCH;
+
+  for(b = 0; b < NB_BATCH; b++)
+    var += (t[b] - mean) * (t[b] - mean);
+  var /= NB_BATCH - 1;
+
+  printf("%-18s %-12s %12lld %12.1f %12.1f %12.1f\n", name, note, nb_call, mean, sqrt(var), min);
+}
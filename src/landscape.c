@@ -0,0 +1,181 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  landscape.c: distributions of the search landscape
+ *
+ *  The distributions are cumulated over all the runs of the process and
+ *  written (as text, one section per distribution) by Landscape_Write.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "landscape.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef struct
+{
+  long long bucket[LAND_NB_BUCKET]; /* bucket[k]: values in [2^(k-1), 2^k - 1] */
+  long long nb;			/* nb of values */
+  double sum;			/* sum of the values (for the mean) */
+  int max;			/* max value */
+}Histo;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static Histo histo[LAND_NB_HISTO];
+
+static long long *var_count;	/* nb of times each var is chosen as max_i */
+static int var_size;		/* nb of elements of var_count */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Write_Histo(FILE *f, char *name, Histo *h);
+
+
+
+
+/*
+ *  LANDSCAPE_START
+ *
+ *  Called at the start of a run (size: nb of variables).
+ */
+void
+Landscape_Start(int size)
+{
+  if (size > var_size)
+    {
+      var_count = (long long *) realloc(var_count, size * sizeof(long long));
+      if (var_count == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+      memset(var_count + var_size, 0, (size - var_size) * sizeof(long long));
+      var_size = size;
+    }
+
+  landscape_on = 1;
+}
+
+
+
+
+/*
+ *  LANDSCAPE_ADD
+ *
+ *  Records a value in a distribution (LAND_...).
+ */
+void
+Landscape_Add(int histo_no, int value)
+{
+  Histo *h = histo + histo_no;
+  int k = (value <= 0) ? 0 : 32 - __builtin_clz(value);
+
+  if (k >= LAND_NB_BUCKET)
+    k = LAND_NB_BUCKET - 1;
+
+  h->bucket[k]++;
+  h->nb++;
+  h->sum += value;
+  if (value > h->max)
+    h->max = value;
+}
+
+
+
+
+/*
+ *  LANDSCAPE_VAR
+ *
+ *  Records the choice of variable i as max_i.
+ */
+void
+Landscape_Var(int i)
+{
+  if ((unsigned) i < (unsigned) var_size)
+    var_count[i]++;
+}
+
+
+
+
+/*
+ *  LANDSCAPE_WRITE
+ *
+ *  Writes all distributions in file_name. Returns 0 on error.
+ */
+int
+Landscape_Write(char *file_name, char *bench_name, int param, int nb_run)
+{
+  static char *name[LAND_NB_HISTO] = LAND_HISTO_NAMES;
+  FILE *f;
+  long long nb = 0;
+  int i;
+
+  if ((f = fopen(file_name, "w")) == NULL)
+    {
+      perror(file_name);
+      return 0;
+    }
+
+  fprintf(f, "# search landscape of %s %d (%d runs)\n", bench_name, param, nb_run);
+
+  for(i = 0; i < LAND_NB_HISTO; i++)
+    Write_Histo(f, name[i], histo + i);
+
+  for(i = 0; i < var_size; i++)
+    nb += var_count[i];
+
+  fprintf(f, "\n# var_chosen: %lld choices of max_i\n", nb);
+  fprintf(f, "#%7s %12s %8s\n", "var", "count", "%");
+  for(i = 0; i < var_size; i++)
+    fprintf(f, "%8d %12lld %8.3f\n", i, var_count[i], (nb) ? 100.0 * var_count[i] / nb : 0.0);
+
+  fclose(f);
+  return 1;
+}
+
+
+
+
+/*
+ *  WRITE_HISTO
+ *
+ *  Writes the non-empty part of a distribution.
+ */
+static void
+Write_Histo(FILE *f, char *name, Histo *h)
+{
+  int k, last;
+
+  fprintf(f, "\n# %s: %lld values, mean %.2f, max %d\n", name, h->nb,
+	  (h->nb) ? h->sum / h->nb : 0.0, h->max);
+  fprintf(f, "#%11s %12s %12s %8s\n", "from", "to", "count", "%");
+
+  for(last = LAND_NB_BUCKET - 1; last > 0 && h->bucket[last] == 0; last--)
+    ;
+
+  for(k = 0; k <= last; k++)
+    fprintf(f, "%12lld %12lld %12lld %8.3f\n",
+	    (k == 0) ? 0LL : 1LL << (k - 1),
+	    (k == 0) ? 0LL : (k == LAND_NB_BUCKET - 1) ? (long long) h->max : (1LL << k) - 1,
+	    h->bucket[k], (h->nb) ? 100.0 * h->bucket[k] / h->nb : 0.0);
+}
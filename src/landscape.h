@@ -0,0 +1,67 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  landscape.h: distributions of the search landscape
+ *
+ *  When landscape is set the engine records (over all runs and restarts of
+ *  the process) the length of the plateaus, the cost of the local minima,
+ *  the nb of ties when choosing the variables to swap (list_i_nb/list_j_nb,
+ *  or list_ij_nb in exhaustive mode) and how often each variable is chosen
+ *  as max_i. The histograms use power of 2 buckets: 0, 1, 2-3, 4-7,...
+ */
+
+#ifndef LANDSCAPE_H
+#define LANDSCAPE_H 1
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define LAND_NB_BUCKET       32
+
+enum
+{
+  LAND_PLATEAU,			/* nb of iters without cost change */
+  LAND_LOC_MIN_COST,		/* cost of a local min */
+  LAND_TIES_I,			/* nb of candidates for max_i (or pairs) */
+  LAND_TIES_J,			/* nb of candidates for min_j */
+  LAND_NB_HISTO
+};
+
+#define LAND_HISTO_NAMES  { "plateau_length", "loc_min_cost", "ties_i", "ties_j" }
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+#if !defined(CELL)
+
+int landscape_on;		/* true if the distributions are recorded */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+void Landscape_Start(int size);
+
+void Landscape_Add(int histo, int value);
+
+void Landscape_Var(int i);
+
+int Landscape_Write(char *file_name, char *bench_name, int param, int nb_run);
+
+#else  /* CELL */
+
+#define landscape_on  0
+#define Landscape_Start(size)
+#define Landscape_Add(histo, value)
+#define Landscape_Var(i)
+#define Landscape_Write(file_name, bench_name, param, nb_run)  0
+
+#endif /* CELL */
+
+#endif /* !LANDSCAPE_H */
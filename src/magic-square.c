@@ -341,6 +341,74 @@ Cost_If_Swap(int current_cost, int k1, int k2)
 
 
 
+/*
+ *  COST_IF_CYCLE
+ *
+ *  Evaluates the new total cost for the 3-cycle k1 <- k3 <- k2 <- k1
+ *  (swap of k1/k2 then of k1/k3). The variations of the variables on a
+ *  same line (column) are summed before adjusting its error.
+ */
+
+int
+Cost_If_Cycle(int current_cost, int k1, int k2, int k3)
+{
+  int k[3], l[3], c[3], diff[3];
+  int diff_d1 = 0, diff_d2 = 0;
+  int a, b, s, r;
+  XRef xr;
+
+  k[0] = k1;
+  k[1] = k2;
+  k[2] = k3;
+  diff[0] = sol[k3] - sol[k1];
+  diff[1] = sol[k1] - sol[k2];
+  diff[2] = sol[k2] - sol[k3];
+
+  for(a = 0; a < 3; a++)
+    {
+      xr = xref[k[a]];
+      l[a] = XGetL(xr);
+      c[a] = XGetC(xr);
+      if (XIsOnD1(xr))
+	diff_d1 += diff[a];
+      if (XIsOnD2(xr))
+	diff_d2 += diff[a];
+    }
+
+  r = current_cost;
+
+  for(a = 0; a < 3; a++)
+    {
+      for(b = 0; b < a && l[b] != l[a]; b++) /* first var of this line ? */
+	;
+      if (b == a)
+	{
+	  for(s = 0; b < 3; b++)
+	    if (l[b] == l[a])
+	      s += diff[b];
+	  AdjustL(r, s, l[a]);
+	}
+
+      for(b = 0; b < a && c[b] != c[a]; b++)
+	;
+      if (b == a)
+	{
+	  for(s = 0; b < 3; b++)
+	    if (c[b] == c[a])
+	      s += diff[b];
+	  AdjustC(r, s, c[a]);
+	}
+    }
+
+  AdjustD1(r, diff_d1);
+  AdjustD2(r, diff_d2);
+
+  return r;
+}
+
+
+
+
 /*
  *  EXECUTED_SWAP
  *
@@ -423,6 +491,37 @@ Executed_Swap(int k1, int k2)
 
 
 
+/*
+ *  SWAP_FOOTPRINT
+ *
+ *  The lines, columns and diagonals changed by swapping k1 and k2
+ *  (numbered: lines, then columns, then d1 and d2).
+ */
+
+int
+Swap_Footprint(int k1, int k2, int *cstr)
+{
+  XRef xr1 = xref[k1];
+  XRef xr2 = xref[k2];
+  int n = 0;
+
+  cstr[n++] = XGetL(xr1);
+  cstr[n++] = XGetL(xr2);
+  cstr[n++] = square_length + XGetC(xr1);
+  cstr[n++] = square_length + XGetC(xr2);
+
+  if (XIsOnD1(xr1) || XIsOnD1(xr2))
+    cstr[n++] = 2 * square_length;
+
+  if (XIsOnD2(xr1) || XIsOnD2(xr2))
+    cstr[n++] = 2 * square_length + 1;
+
+  return n;
+}
+
+
+
+
 int param_needed = 1;		/* overwrite var of main.c */
 
 
@@ -9,8 +9,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/resource.h>
 
 #include "ad_solver.h"
+#include "multi.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "hwcount.h"
+#include "landscape.h"
 
 /*-----------*
  * Constants *
@@ -20,6 +28,22 @@
  * Types *
  *-------*/
 
+typedef struct
+{
+  double time;			/* time of the run */
+  long max_rss;			/* peak RSS (in KB) of the process when it ended (see Max_RSS) */
+  long long hw[HW_NB];		/* hardware counters (-1 if not measured) */
+  AdData ad;			/* counters of the run */
+}BenchRun;			/* result of a bench run (sent back by a worker) */
+
+
+typedef struct
+{
+  int conf;			/* configuration */
+  int seed_no;			/* index of the seed in tune_seed[] */
+}TuneJob;			/* a run of the tuner */
+
+
 /*------------------*
  * Global variables *
  *------------------*/
@@ -30,6 +54,58 @@ static int count;
 static int disp_mode;
 static int check_valid;
 static int read_initial;	/* 0=no, 1=yes, 2=all threads use the same (CELL specific) */
+static int nb_workers;		/* nb of processes for bench runs (0=nb of cpus) */
+
+static char buff[256];		/* separator line of the bench table */
+
+static AdData *bench_ad;	/* data of the bench (copied in each worker) */
+static int *bench_seed;		/* seed of each bench run (for workers) */
+
+static char *bench_name;	/* name of the bench (argv[0] without the path) */
+static char *out_file;		/* file to save each run (.json or .csv) or NULL */
+static BenchRun *bench_run;	/* all recorded runs (in order of arrival) */
+static int nb_bench_run;	/* nb of recorded runs */
+
+static char **portfolio;	/* configurations of the portfolio (tuning options) */
+static int nb_portfolio;	/* nb of configurations (0 = no portfolio) */
+static AdData portfolio_base;	/* data before applying a configuration */
+static AdData *portfolio_ad;	/* data of the current run (copied in each worker) */
+static int portfolio_winner;	/* configuration which solved the last run (or -1) */
+static int *portfolio_wins;	/* nb of runs solved by each configuration */
+
+static int time_limit;		/* max nb of secs of a run performed by a worker (0=none) */
+
+static int hw_counters;		/* measure hardware counters around Solve (-H) */
+
+static char *landscape_file;	/* file to write the landscape distributions or NULL */
+
+static char *sol_file;		/* file to stream the solutions (-n) or NULL (stdout) */
+static FILE *sol_out;		/* stream of the solutions */
+static int sol_binary;		/* binary records (int32 values) instead of text lines */
+
+static int live_update;		/* read data changes on stdin and re-solve (-U) */
+
+static char *tune_params;	/* params (sizes) to tune the portfolio for (or NULL) */
+static AdData tune_cmd_line;	/* data as set by the command-line */
+static int tune_param;		/* param currently tuned */
+static int *tune_seed;		/* seeds used to evaluate a configuration */
+static TuneJob *tune_job;	/* runs of the current round */
+
+				/* counters accumulated across bench runs */
+static int nb_iter_cum;
+static int nb_local_min_cum;
+static int nb_swap_cum;
+static int nb_reset_cum;
+static double nb_same_var_by_iter_cum;
+
+static int nb_restart_cum,                nb_restart_min,              nb_restart_max;
+static double time_cum,                   time_min,                    time_max;
+
+static int nb_iter_tot_cum,               nb_iter_tot_min,             nb_iter_tot_max;
+static int nb_local_min_tot_cum,          nb_local_min_tot_min,        nb_local_min_tot_max;
+static int nb_swap_tot_cum,               nb_swap_tot_min,             nb_swap_tot_max;
+static int nb_reset_tot_cum,              nb_reset_tot_min,            nb_reset_tot_max;
+static double nb_same_var_by_iter_tot_cum, nb_same_var_by_iter_tot_min, nb_same_var_by_iter_tot_max;
 
 
 int param_needed;		/* overwritten by benches if an argument is needed */
@@ -39,12 +115,52 @@ int param_needed;		/* overwritten by benches if an argument is needed */
  * Prototypes *
  *------------*/
 
+static void Init_Data(AdData *p_ad);
+
 static void Set_Initial(AdData *p_ad);
 
 static void Verify_Sol(AdData *p_ad);
 
+static void Bench_Record(int i, AdData *p_ad, double time_one, long max_rss, long long *hw);
+
+static void Hw_Display(BenchRun *run, int nb);
+
+static void Verify_Display(BenchRun *run, int nb);
+
+static void Enumerate_Start(AdData *p_ad);
+
+static int Write_Solution(AdData *p_ad, int no, void *data);
+
+static void Live_Update(AdData *p_ad);
+
+static long Max_RSS(void);
+
+static void Bench_Percentiles(void);
+
+static void Bench_Output(AdData *p_ad, int seed);
+
+static void Bench_Parallel(AdData *p_ad);
+
+static void Add_Portfolio(char *conf);
+
+static void Read_Portfolio(char *file_name);
+
+static void Portfolio_Params(int k, AdData *p_ad);
+
+static void Portfolio_Solve(AdData *p_ad);
+
+static long Run_Time(void);
+
+static void Tune(AdData *p_ad);
+
 static void Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad);
 
+static void Parse_Restart_Policy(char *arg, AdData *p_ad);
+
+static void Parse_Reset_Strategy(char *arg, AdData *p_ad);
+
+static int Parse_Tuning_Option(char *opt, char *arg, AdData *p_ad);
+
 #define Div_Round_Up(x, y)   (((x) + (y) - 1) / (y))
 
 
@@ -70,6 +186,9 @@ void Solve(AdData *p_ad);
 #endif	/* !CELL */
 
 
+#define Solve_Run(p_ad)  ((nb_portfolio > 0) ? Portfolio_Solve(p_ad) : Solve(p_ad))
+
+
 
 /*
  *  MAIN
@@ -81,35 +200,1213 @@ main(int argc, char *argv[])
 {
   static AdData data;		/* to be init with 0 (debug only) */
   AdData *p_ad = &data;
-  int i;
+  int i, seed0;
+  long long hw[HW_NB];
+
+  double time_one0, time_one;
+  double nb_same_var_by_iter, nb_same_var_by_iter_tot;
+
+  Parse_Cmd_Line(argc, argv, p_ad);
+
+  if (p_ad->seed < 0)
+    p_ad->seed = Randomize();
+  else
+    Randomize_Seed(p_ad->seed);
+  seed0 = p_ad->seed;
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  //setlinebuf(stdout);
+
+  if (tune_params)
+    {
+      Tune(p_ad);
+      return 0;
+    }
+
+  Init_Data(p_ad);
+
+  if (p_ad->debug > 0 && !ad_has_debug)
+    printf("Warning ad_solver is not compiled with debugging support\n");
+
+  if (p_ad->log_file && !ad_has_log_file)
+    printf("Warning ad_solver is not compiled with log file support\n");
+
+  if (hw_counters && nb_portfolio > 0)
+    {
+      printf("Warning hardware counters are not measured with a portfolio (other processes)\n");
+      hw_counters = 0;
+    }
+
+  if (hw_counters)		/* check once (before workers are created) */
+    {
+      if (!Hw_Start())
+	hw_counters = 0;
+      Hw_Stop(hw);
+    }
+
+  printf("current random seed used: %d\n", p_ad->seed);
+  printf("variables of loc min are frozen for: %d swaps\n", p_ad->freeze_loc_min);
+  printf("variables swapped    are frozen for: %d swaps\n", p_ad->freeze_swap);
+  if (p_ad->reset_percent >= 0)
+    printf("%d %% = ", p_ad->reset_percent);
+  printf("%d %svariables are reset when %d variables are frozen\n", 
+	 p_ad->nb_var_to_reset, (p_ad->reset_strategy == AD_RESET_WORST) ? "worst " :
+	 (p_ad->reset_strategy == AD_RESET_FROZEN) ? "frozen " : "", p_ad->reset_limit);
+  printf("probability to select a local min (instead of staying on a plateau): ");
+  if (p_ad->prob_select_loc_min >=0 && p_ad->prob_select_loc_min <= 100)
+    printf("%d %%\n", p_ad->prob_select_loc_min);
+  else
+    printf("not used\n");
+  switch(p_ad->restart_policy)
+    {
+    case AD_RESTART_LUBY:
+      printf("restart after %d * luby(k) iterations", p_ad->restart_limit);
+      break;
+    case AD_RESTART_GEOM:
+      printf("restart after %d * %g^k iterations", p_ad->restart_limit, p_ad->restart_factor / 100.0);
+      break;
+    case AD_RESTART_STAG:
+      printf("restart after %d iterations without improvement", p_ad->restart_limit);
+      break;
+    default:
+      printf("abort when %d iterations are reached and restart", p_ad->restart_limit);
+    }
+  printf(" at most %d times\n", p_ad->restart_max);
+  if (p_ad->adapt_window > 0)
+    printf("parameters are adapted every %d iterations\n", p_ad->adapt_window);
+  if (p_ad->tabu_window > 0)
+    printf("configurations of the last %d swaps are tabu (non-improving moves)\n", p_ad->tabu_window);
+  if (p_ad->multi_swap > 1)
+    {
+      if (ad_no_footprint_fct)
+	printf("-m ignored: this benchmark does not define Swap_Footprint\n");
+      else
+	printf("up to %d non-interacting improving swaps per iteration\n", p_ad->multi_swap);
+    }
+  if (p_ad->weight_decay > 0)
+    {
+      if (ad_no_violated_fct)
+	printf("-y ignored: this benchmark does not define Violated_Constraints\n");
+      else
+	printf("resets raise the constraint weights, halved every %d raises\n", p_ad->weight_decay);
+    }
+  if (p_ad->compound_moves > 0)
+    {
+      if (!ad_no_next_i_fct || !ad_no_next_j_fct)
+	printf("-E ignored: this benchmark restricts the swaps (Next_I/Next_J)\n");
+      else
+	printf("local mins first try 3-cycles with %d partners\n", p_ad->compound_moves);
+    }
+  if (p_ad->endgame_cost > 0)
+    {
+      if (!ad_no_next_i_fct || !ad_no_next_j_fct)
+	printf("-Z ignored: this benchmark restricts the swaps (Next_I/Next_J)\n");
+      else
+	printf("local mins of cost <= %d first try a bounded search\n", p_ad->endgame_cost);
+    }
+  if (p_ad->nb_blocks > 1)
+    printf("the initial configuration is first repaired by rounds of %d blocks\n", p_ad->nb_blocks);
+
+  if (p_ad->kbench_calls > 0)
+    {
+      Set_Initial(p_ad);
+      p_ad->seed = Random(65536);
+      Solve(p_ad);
+      return 0;
+    }
+
+  if (nb_portfolio > 0)
+    {
+      portfolio_base = *p_ad;
+      portfolio_wins = (int *) calloc(nb_portfolio, sizeof(int));
+      if (portfolio_wins == NULL)
+	{
+	  fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	  exit(1);
+	}
+
+      printf("portfolio of %d configurations (one process each):\n", nb_portfolio);
+      for(i = 0; i < nb_portfolio; i++)
+	{
+	  Portfolio_Params(i, &data);	/* check it (the run will reinit data) */
+	  printf("  %3d: %s\n", i + 1, portfolio[i]);
+	}
+      *p_ad = portfolio_base;
+    }
+
+  bench_run = (BenchRun *) malloc(((count > 0) ? count : 1) * sizeof(BenchRun));
+  if (bench_run == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  if (count <= 0)
+    {
+      Set_Initial(p_ad);
+
+      if (p_ad->nb_solutions > 1)
+	Enumerate_Start(p_ad);
+
+      p_ad->seed = Random(65536);
+      if (hw_counters)
+	Hw_Start();
+      time_one0 = (double) Run_Time();
+      Solve_Run(p_ad);
+      time_one = ((double) Run_Time() - time_one0) / 1000;
+      Hw_Stop(bench_run[0].hw);
+
+      if (p_ad->exhaustive)
+	printf("exhaustive search\n");
+
+      if (p_ad->nb_solutions > 1)
+	{
+	  if (sol_out != stdout)
+	    fclose(sol_out);
+	  printf("%d distinct solutions (%d found again) in %.2f secs: %.1f solutions/sec\n",
+		 p_ad->nb_sol_found, p_ad->nb_sol_dup, time_one,
+		 (time_one > 0) ? p_ad->nb_sol_found / time_one : 0);
+	}
+      else
+	{
+	  if (count < 0)
+	    Display_Solution(p_ad);
+
+	  Verify_Sol(p_ad);
+
+	  if (p_ad->total_cost)
+	    printf("*** NOT SOLVED (cost of this pseudo-solution: %d) ***\n", p_ad->total_cost);
+	}
+
+      if (nb_portfolio > 0 && portfolio_winner >= 0)
+	printf("%s by configuration %d: %s\n", (p_ad->total_cost) ? "best cost reached" : "solved",
+	       portfolio_winner + 1, portfolio[portfolio_winner]);
+
+      if (count == 0)
+	{
+	  nb_same_var_by_iter = (p_ad->nb_iter) ? (double) p_ad->nb_same_var / p_ad->nb_iter : 0;
+	  nb_same_var_by_iter_tot = (p_ad->nb_iter_tot) ? (double) p_ad->nb_same_var_tot / p_ad->nb_iter_tot : 0;
+
+	  printf("%5d %7.2f %7d %7d %7d %7d %7.1f %7d %7d %7d %7d %7.1f\n", 
+		 p_ad->nb_restart, time_one, 
+		 p_ad->nb_iter, p_ad->nb_local_min, p_ad->nb_swap, 
+		 p_ad->nb_reset, nb_same_var_by_iter,
+		 p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot, 
+		 p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
+	}
+      else
+	{
+	  printf("in %.2f secs (%d iters, %d swaps, %d restarts)\n", 
+		 time_one, p_ad->nb_iter_tot, p_ad->nb_swap_tot, p_ad->nb_restart);
+	  if (p_ad->nb_restart > 0)
+	    printf("%.1f iters per restart\n", (double) p_ad->nb_iter_tot / (p_ad->nb_restart + 1));
+	}
+
+      if (p_ad->adapt_window > 0)
+	printf("%d adaptations of the parameters\n", p_ad->nb_adapt);
+
+      if (p_ad->multi_swap > 1 && !ad_no_footprint_fct)
+	printf("%d swaps done in addition to the selected ones\n", p_ad->nb_extra_swap);
+
+      if (p_ad->weight_decay > 0 && !ad_no_violated_fct)
+	printf("%d raises of the constraint weights\n", p_ad->nb_weight_raise);
+
+      if (p_ad->compound_moves > 0 && ad_no_next_i_fct && ad_no_next_j_fct)
+	printf("%d local mins escaped by a 3-cycle\n", p_ad->nb_compound);
+
+      if (p_ad->endgame_cost > 0 && ad_no_next_i_fct && ad_no_next_j_fct)
+	printf("%d endgame searches, %d found a solution\n", p_ad->nb_endgame, p_ad->nb_endgame_ok);
+
+      if (p_ad->nb_blocks > 1)
+	printf("%d rounds of %d blocks (%d iters in the blocks)\n",
+	       p_ad->nb_block_round, p_ad->nb_blocks, p_ad->nb_block_iter);
+
+      if (p_ad->tabu_window > 0)
+	printf("%d moves refused (configuration seen in the last %d swaps)\n",
+	       p_ad->nb_tabu, p_ad->tabu_window);
+
+      if (nb_portfolio == 0)	/* else solved by other processes */
+	Ad_Prof_Display();
+
+      bench_run[0].ad = *p_ad;
+      if (hw_counters)
+	Hw_Display(bench_run, 1);
+
+      if (p_ad->verify_interval > 0 || p_ad->verify_ppm > 0)
+	Verify_Display(bench_run, 1);
+
+      if (out_file)
+	{
+	  bench_run[0].time = time_one;
+	  bench_run[0].max_rss = Max_RSS();
+	  bench_run[0].ad = *p_ad;
+	  nb_bench_run = 1;
+	  Bench_Output(p_ad, seed0);
+	}
+
+      if (landscape_file && Landscape_Write(landscape_file, bench_name, p_ad->param, 1))
+	printf("landscape distributions written in %s\n", landscape_file);
+
+      if (live_update)
+	Live_Update(p_ad);
+
+      return 0;
+    }
+
+  if (nb_workers != 1)
+    {
+      if (nb_workers <= 0)
+	nb_workers = Multi_Nb_Cpus();
+      printf("bench runs are spread over %d processes\n", nb_workers);
+    }
+
+  putchar('\n');
+
+  sprintf(buff, "|Count|restart|    time |   iters | loc min |   swaps "
+	  "|  resets |same/iter|\n");
+
+  if (param_needed)
+    printf("%*d\n", (int) strlen(buff)/2, p_ad->param);
+  
+  printf("%s", buff);
+  for(i = 0; buff[i] != '\n'; i++)
+    if (buff[i] != '|')
+      buff[i] = '-';
+  printf("%s", buff);
+  printf("\n\n");
+
+  
+  nb_restart_cum = time_cum = 0;
+
+  nb_iter_cum = nb_local_min_cum = nb_swap_cum = nb_reset_cum = 0;
+  nb_same_var_by_iter_cum = 0;
+
+
+  nb_iter_tot_cum = nb_local_min_tot_cum = nb_swap_tot_cum = nb_reset_tot_cum = 0;
+  nb_same_var_by_iter_tot_cum = 0;
+
+  nb_restart_min = (1 << 30);
+  time_min = 1e100;
+  
+  nb_iter_tot_min = nb_local_min_tot_min = nb_swap_tot_min = nb_reset_tot_min = (1 << 30);
+  nb_same_var_by_iter_tot_min = 1e100;
+
+  nb_restart_max = 0;
+  time_max = 0;
+ 
+  nb_iter_tot_max = nb_local_min_tot_max = nb_swap_tot_max = nb_reset_tot_max = 0;
+  nb_same_var_by_iter_tot_max = 0;
+
+
+  if (nb_workers != 1)
+    Bench_Parallel(p_ad);
+  else
+    for(i = 1; i <= count; i++)
+      {
+	Set_Initial(p_ad);
+
+	p_ad->seed = Random(65536);
+	if (hw_counters)
+	  Hw_Start();
+	time_one0 = (double) Run_Time();
+	Solve_Run(p_ad);
+	time_one = ((double) Run_Time() - time_one0) / 1000;
+	Hw_Stop(hw);
+
+	Verify_Sol(p_ad);
+
+	Bench_Record(i, p_ad, time_one, Max_RSS(), hw);
+      }
+
+  if (count <= 0)
+    return 0;
+
+  printf("| min | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	 nb_restart_min, time_min,
+	 nb_iter_tot_min, nb_local_min_tot_min, nb_swap_tot_min,
+	 nb_reset_tot_min, nb_same_var_by_iter_tot_min);
+
+  printf("| max | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	 nb_restart_max, time_max,
+	 nb_iter_tot_max, nb_local_min_tot_max, nb_swap_tot_max,
+	 nb_reset_tot_max, nb_same_var_by_iter_tot_max);
+
+  Bench_Percentiles();
+
+  if (hw_counters)
+    Hw_Display(bench_run, nb_bench_run);
+
+  if (p_ad->verify_interval > 0 || p_ad->verify_ppm > 0)
+    Verify_Display(bench_run, nb_bench_run);
+
+  if (out_file)
+    Bench_Output(p_ad, seed0);
+
+  if (landscape_file && Landscape_Write(landscape_file, bench_name, p_ad->param, count))
+    printf("\nlandscape distributions written in %s\n", landscape_file);
+
+  if (nb_restart_cum > 0)
+    printf("\n%d restarts, %.1f iters per restart\n", nb_restart_cum,
+	   (double) nb_iter_tot_cum / (nb_restart_cum + nb_bench_run));
+
+  if (nb_portfolio > 0)
+    {
+      printf("\nruns solved by each configuration:\n");
+      for(i = 0; i < nb_portfolio; i++)
+	printf("%5d  %3d: %s\n", portfolio_wins[i], i + 1, portfolio[i]);
+    }
+
+  if (nb_workers == 1 && nb_portfolio == 0) /* else solved by other processes */
+    Ad_Prof_Display();
+
+
+
+  return 0;
+}
+
+
+
+/*
+ *  LIVE_UPDATE
+ *
+ *  Live session: reads data changes on stdin (one per line, syntax given
+ *  by the bench Change_Data) and, after each one, re-solves starting from
+ *  the current solution (do_not_init=2: the model state is kept).
+ */
+static void
+Live_Update(AdData *p_ad)
+{
+  char line[1024];
+  double time_one0, time_one;
+  int cost;
+
+  printf("\nlive session: enter a data change per line (EOF to end)\n");
+  fflush(stdout);
+
+  while(fgets(line, sizeof(line), stdin))
+    {
+      line[strcspn(line, "\r\n")] = '\0';
+      if (*line == '\0')
+	continue;
+
+      if ((cost = Change_Data(line, p_ad)) < 0)
+	{
+	  printf("invalid change: %s\n", line);
+	  fflush(stdout);
+	  continue;
+	}
+
+      printf("change: %s (cost of the current solution: %d)\n", line, cost);
+      p_ad->total_cost = cost;
+      p_ad->do_not_init = 2;
+
+      time_one0 = (double) Run_Time();
+      Solve(p_ad);
+      time_one = ((double) Run_Time() - time_one0) / 1000;
+
+      if (count < 0)
+	Display_Solution(p_ad);
+
+      Verify_Sol(p_ad);
+
+      if (p_ad->total_cost)
+	printf("*** NOT SOLVED (cost of this pseudo-solution: %d) ***\n", p_ad->total_cost);
+
+      printf("re-solved in %.2f secs (%d iters, %d swaps, %d restarts)\n",
+	     time_one, p_ad->nb_iter_tot, p_ad->nb_swap_tot, p_ad->nb_restart);
+      fflush(stdout);
+    }
+
+  p_ad->do_not_init = 0;
+}
+
+
+
+
+/*
+ *  ENUMERATE_START
+ *
+ *  Prepares the enumeration of nb_solutions distinct solutions: each one
+ *  is streamed (Write_Solution as on_solution hook) to sol_file or stdout.
+ */
+static void
+Enumerate_Start(AdData *p_ad)
+{
+  static AdObserver observer;
+  int n;
+
+  sol_out = stdout;
+  if (sol_file && strcmp(sol_file, "-") != 0)
+    {
+      n = strlen(sol_file);
+      sol_binary = (n > 4 && strcmp(sol_file + n - 4, ".bin") == 0);
+      if ((sol_out = fopen(sol_file, (sol_binary) ? "wb" : "w")) == NULL)
+	{
+	  perror(sol_file);
+	  exit(1);
+	}
+    }
+
+  observer.on_solution = Write_Solution;
+  p_ad->observer = &observer;
+
+  printf("enumerating %d distinct solutions (%s)\n", p_ad->nb_solutions,
+	 (sol_out == stdout) ? "stdout" : sol_file);
+}
+
+
+
+
+/*
+ *  WRITE_SOLUTION
+ *
+ *  Hook called on each new solution: writes a record (a line of values or
+ *  size int32 values in binary). Checks it with -c.
+ */
+static int
+Write_Solution(AdData *p_ad, int no, void *data)
+{
+  int32_t v;
+  int i;
+
+  if (sol_binary)
+    for(i = 0; i < p_ad->size; i++)
+      {
+	v = p_ad->sol[i];
+	fwrite(&v, sizeof(v), 1, sol_out);
+      }
+  else
+    for(i = 0; i < p_ad->size; i++)
+      fprintf(sol_out, "%d%c", p_ad->sol[i], (i < p_ad->size - 1) ? ' ' : '\n');
+
+  Verify_Sol(p_ad);
+
+  return 0;
+}
+
+
+
+
+/*
+ *  BENCH_RECORD
+ *
+ *  Accumulates the counters of the ith bench run and displays them.
+ */
+static void
+Bench_Record(int i, AdData *p_ad, double time_one, long max_rss, long long *hw)
+{
+  double nb_same_var_by_iter, nb_same_var_by_iter_tot;
+  BenchRun *run = bench_run + nb_bench_run++;
+
+  run->time = time_one;
+  run->max_rss = max_rss;
+  memcpy(run->hw, hw, sizeof(run->hw));
+  run->ad = *p_ad;
+
+  if (disp_mode == 2 && nb_restart_cum > 0)
+    printf("\033[A\033[K");
+  printf("\033[A\033[K\033[A\033[256D");
+
+
+  nb_same_var_by_iter = (p_ad->nb_iter) ? (double) p_ad->nb_same_var / p_ad->nb_iter : 0;
+  nb_same_var_by_iter_tot = (p_ad->nb_iter_tot) ? (double) p_ad->nb_same_var_tot / p_ad->nb_iter_tot : 0;
+
+  nb_restart_cum += p_ad->nb_restart;
+  time_cum += time_one;
+  nb_iter_cum += p_ad->nb_iter;
+  nb_local_min_cum += p_ad->nb_local_min;
+  nb_swap_cum += p_ad->nb_swap;
+  nb_reset_cum += p_ad->nb_reset;
+  nb_same_var_by_iter_cum += nb_same_var_by_iter;
+
+  nb_iter_tot_cum += p_ad->nb_iter_tot;
+  nb_local_min_tot_cum += p_ad->nb_local_min_tot;
+  nb_swap_tot_cum += p_ad->nb_swap_tot;
+  nb_reset_tot_cum += p_ad->nb_reset_tot;
+  nb_same_var_by_iter_tot_cum += nb_same_var_by_iter_tot;
+
+  if (nb_restart_min > p_ad->nb_restart)
+    nb_restart_min = p_ad->nb_restart;
+  if (time_min > time_one)
+    time_min = time_one;
+  if (nb_iter_tot_min > p_ad->nb_iter_tot)
+    nb_iter_tot_min = p_ad->nb_iter_tot;
+  if (nb_local_min_tot_min > p_ad->nb_local_min_tot)
+    nb_local_min_tot_min = p_ad->nb_local_min_tot;
+  if (nb_swap_tot_min > p_ad->nb_swap_tot)
+    nb_swap_tot_min = p_ad->nb_swap_tot;
+  if (nb_reset_tot_min > p_ad->nb_reset_tot)
+    nb_reset_tot_min = p_ad->nb_reset_tot;
+  if (nb_same_var_by_iter_tot_min > nb_same_var_by_iter_tot)
+    nb_same_var_by_iter_tot_min = nb_same_var_by_iter_tot;
+
+  if (nb_restart_max < p_ad->nb_restart)
+    nb_restart_max = p_ad->nb_restart;
+  if (time_max < time_one)
+    time_max = time_one;
+  if (nb_iter_tot_max < p_ad->nb_iter_tot)
+    nb_iter_tot_max = p_ad->nb_iter_tot;
+  if (nb_local_min_tot_max < p_ad->nb_local_min_tot)
+    nb_local_min_tot_max = p_ad->nb_local_min_tot;
+  if (nb_swap_tot_max < p_ad->nb_swap_tot)
+    nb_swap_tot_max = p_ad->nb_swap_tot;
+  if (nb_reset_tot_max < p_ad->nb_reset_tot)
+    nb_reset_tot_max = p_ad->nb_reset_tot;
+  if (nb_same_var_by_iter_tot_max < nb_same_var_by_iter_tot)
+    nb_same_var_by_iter_tot_max = nb_same_var_by_iter_tot;
+
+
+  switch(disp_mode)
+    {
+    case 0:			/* only last iter counters */
+    case 2:			/* last iter followed by restart if needed */
+      printf("|%4d | %5d%c| %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	     i, p_ad->nb_restart, (p_ad->total_cost == 0) ? ' ' : 'N', time_one,
+	     p_ad->nb_iter, p_ad->nb_local_min, p_ad->nb_swap,
+	     p_ad->nb_reset, nb_same_var_by_iter);
+
+      if (disp_mode == 2 && p_ad->nb_restart > 0)
+	printf("|     |       |         | %7d | %7d | %7d | %7d | %7.1f |\n",
+	       p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot,
+	       p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
+
+      printf("%s", buff);
+
+      printf("| avg | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	     nb_restart_cum / i, time_cum / i,
+	     nb_iter_cum / i, nb_local_min_cum / i, nb_swap_cum / i,
+	     nb_reset_cum / i, nb_same_var_by_iter_cum / i);
+
+      if (disp_mode == 2 && nb_restart_cum > 0)
+	printf("|     |       |         | %7d | %7d | %7d | %7d | %7.1f |\n",
+	       nb_iter_tot_cum / i, nb_local_min_tot_cum / i, nb_swap_tot_cum / i,
+	       nb_reset_tot_cum / i, nb_same_var_by_iter_tot_cum / i);
+
+      break;
+
+    case 1:			/* only total (restart + last iter) counters */
+      printf("|%4d | %5d%c| %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	     i, p_ad->nb_restart, (p_ad->total_cost == 0) ? ' ' : 'N', time_one,
+	     p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot,
+	     p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
+
+      printf("%s", buff);
+
+      printf("| avg | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
+	     nb_restart_cum / i, time_cum / i,
+	     nb_iter_tot_cum / i, nb_local_min_tot_cum / i, nb_swap_tot_cum / i,
+	     nb_reset_tot_cum / i, nb_same_var_by_iter_tot_cum / i);
+      break;
+    }
+}
+
+
+
+
+/*
+ *  MAX_RSS
+ *
+ *  Returns the peak resident set size (in KB) of this process and of its
+ *  terminated children (the walkers of a portfolio). It is not a per-run
+ *  value: for runs done in sequence by the same process (or by the same
+ *  worker) this is the peak so far, hence the process_max_rss_kb name of
+ *  the column (see Bench_Output).
+ */
+static long
+Max_RSS(void)
+{
+  struct rusage self, children;
+
+  getrusage(RUSAGE_SELF, &self);
+  getrusage(RUSAGE_CHILDREN, &children);
+
+  return (self.ru_maxrss > children.ru_maxrss) ? self.ru_maxrss : children.ru_maxrss;
+}
+
+
+
+
+/*
+ *  HW_DISPLAY
+ *
+ *  Displays the hardware counters of nb runs: average per run and per
+ *  iteration (only the runs where the counter was measured are used).
+ */
+static void
+Hw_Display(BenchRun *run, int nb)
+{
+  static char *name[HW_NB] = HW_NAMES;
+  double sum[HW_NB], iter[HW_NB];
+  int n[HW_NB];
+  int i, k;
+
+  for(k = 0; k < HW_NB; k++)
+    {
+      sum[k] = iter[k] = 0;
+      n[k] = 0;
+      for(i = 0; i < nb; i++)
+	if (run[i].hw[k] >= 0)
+	  {
+	    sum[k] += run[i].hw[k];
+	    iter[k] += run[i].ad.nb_iter_tot;
+	    n[k]++;
+	  }
+    }
+
+  printf("\nhardware counters %18s %14s\n", (nb > 1) ? "avg per run" : "", "per iter");
+  for(k = 0; k < HW_NB; k++)
+    if (n[k] == 0)
+      printf("  %-15s %18s\n", name[k], "not available");
+    else
+      printf("  %-15s %18.0f %14.2f\n", name[k], sum[k] / n[k], (iter[k] > 0) ? sum[k] / iter[k] : 0);
+
+  if (n[HW_CYCLES] > 0 && n[HW_INSTRUCTIONS] == n[HW_CYCLES] && sum[HW_CYCLES] > 0)
+    printf("  %-15s %18.2f\n", "IPC", sum[HW_INSTRUCTIONS] / sum[HW_CYCLES]);
+}
+
+
+
+
+/*
+ *  VERIFY_DISPLAY
+ *
+ *  Displays the result of the shadow verifications of nb runs and the
+ *  first divergence (with the seed to replay the run).
+ */
+static void
+Verify_Display(BenchRun *run, int nb)
+{
+  int nb_verify = 0, nb_fail = 0, nb_run_fail = 0;
+  int i, first = -1;
+
+  for(i = 0; i < nb; i++)
+    {
+      nb_verify += run[i].ad.nb_verify;
+      nb_fail += run[i].ad.nb_verify_fail;
+      if (run[i].ad.nb_verify_fail > 0 && nb_run_fail++ == 0)
+	first = i;
+    }
+
+  printf("\nshadow verification: %d checks, ", nb_verify);
+  if (first < 0)
+    {
+      printf("no divergence\n");
+      return;
+    }
+
+  printf("%d divergences", nb_fail);
+  if (nb > 1)
+    printf(" in %d runs, first in run %d", nb_run_fail, first + 1);
+  printf(" at iter %d (seed %d)\n", run[first].ad.verify_fail_iter, run[first].ad.seed);
+}
+
+
+
+
+#define NB_COLUMN  7		/* nb of columns of the bench table */
+
+/*
+ *  BENCH_COLUMN
+ *
+ *  Returns the value of the kth column of the bench table for a run.
+ */
+static double
+Bench_Column(BenchRun *run, int k)
+{
+  AdData *p_ad = &run->ad;
+
+  switch(k)
+    {
+    case 0: return p_ad->nb_restart;
+    case 1: return run->time;
+    case 2: return p_ad->nb_iter_tot;
+    case 3: return p_ad->nb_local_min_tot;
+    case 4: return p_ad->nb_swap_tot;
+    case 5: return p_ad->nb_reset_tot;
+    }
+  return (p_ad->nb_iter_tot) ? (double) p_ad->nb_same_var_tot / p_ad->nb_iter_tot : 0;
+}
+
+
+
+
+static int
+Cmp_Double(const void *x, const void *y)
+{
+  double a = *(double *) x, b = *(double *) y;
+
+  return (a < b) ? -1 : (a > b);
+}
+
+
+
+
+/*
+ *  PERCENTILES
+ *
+ *  Computes the min, avg, median, p90, p99 and max (nearest rank) of the
+ *  kth column over all recorded runs.
+ */
+static void
+Percentiles(int k, double q[6])
+{
+  static double *v;
+  double sum = 0;
+  int i, n = nb_bench_run;
+
+  if (v == NULL && (v = (double *) malloc(((count > 0) ? count : 1) * sizeof(double))) == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  for(i = 0; i < n; i++)
+    sum += (v[i] = Bench_Column(bench_run + i, k));
+
+  qsort(v, n, sizeof(double), Cmp_Double);
+
+#define Rank(p)  v[((int) ((p) * n + 0.999999) > 0) ? (int) ((p) * n + 0.999999) - 1 : 0]
+
+  q[0] = v[0];
+  q[1] = sum / n;
+  q[2] = Rank(0.50);
+  q[3] = Rank(0.90);
+  q[4] = Rank(0.99);
+  q[5] = v[n - 1];
+}
+
+
+
+
+/*
+ *  BENCH_PERCENTILES
+ *
+ *  Displays the median, p90 and p99 rows of the bench table.
+ */
+static void
+Bench_Percentiles(void)
+{
+  static char *name[] = { "med", "p90", "p99" };
+  double q[NB_COLUMN][6];
+  int i, k;
+
+  if (nb_bench_run == 0)
+    return;
+
+  for(k = 0; k < NB_COLUMN; k++)
+    Percentiles(k, q[k]);
+
+  for(i = 0; i < 3; i++)
+    printf("| %s | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n", name[i],
+	   (int) q[0][i + 2], q[1][i + 2], (int) q[2][i + 2], (int) q[3][i + 2],
+	   (int) q[4][i + 2], (int) q[5][i + 2], q[6][i + 2]);
+}
+
+
+
+
+/*
+ *  BENCH_OUTPUT
+ *
+ *  Saves all recorded runs in out_file: JSON if its suffix is .json else
+ *  CSV (one line per run, the summary as # comments).
+ */
+static void
+Bench_Output(AdData *p_ad, int seed)
+{
+  static char *col_name[NB_COLUMN] =
+    { "restarts", "time", "iter_tot", "local_min_tot", "swap_tot", "reset_tot", "same_var_by_iter_tot" };
+  static char *q_name[6] = { "min", "avg", "med", "p90", "p99", "max" };
+  static char *hw_name[HW_NB] = HW_NAMES;
+  char *suffix = strrchr(out_file, '.');
+  int json = (suffix && strcmp(suffix, ".json") == 0);
+  int threads = (nb_portfolio > 0) ? nb_portfolio : 1;
+  double q[6];
+  BenchRun *run;
+  AdData *r_ad;
+  FILE *f;
+  int i, k;
+
+  if ((f = fopen(out_file, "w")) == NULL)
+    {
+      perror(out_file);
+      return;
+    }
+
+  if (json)
+    fprintf(f, "{\n  \"bench\": \"%s\",\n  \"param\": %d,\n  \"seed\": %d,\n"
+	    "  \"threads\": %d,\n  \"workers\": %d,\n  \"runs\": [\n",
+	    bench_name, p_ad->param, seed, threads, nb_workers);
+  else
+    fprintf(f, "bench,param,threads,run,seed,cost,restarts,time,iter,local_min,swaps,resets,"
+	    "same_var_by_iter,iter_tot,local_min_tot,swap_tot,reset_tot,same_var_by_iter_tot,"
+	    "process_max_rss_kb%s\n", (hw_counters) ? ",cycles,instructions,llc_misses,branch_misses" : "");
+
+  for(i = 0; i < nb_bench_run; i++)
+    {
+      run = bench_run + i;
+      r_ad = &run->ad;
+      if (json)
+	fprintf(f, "    { \"run\": %d, \"seed\": %d, \"cost\": %d, \"restarts\": %d, \"time\": %.3f, "
+		"\"iter\": %d, \"local_min\": %d, \"swaps\": %d, \"resets\": %d, "
+		"\"same_var_by_iter\": %.2f, \"iter_tot\": %d, \"local_min_tot\": %d, "
+		"\"swap_tot\": %d, \"reset_tot\": %d, \"same_var_by_iter_tot\": %.2f, "
+		"\"process_max_rss_kb\": %ld",
+		i + 1, r_ad->seed, r_ad->total_cost, r_ad->nb_restart, run->time,
+		r_ad->nb_iter, r_ad->nb_local_min, r_ad->nb_swap, r_ad->nb_reset,
+		(r_ad->nb_iter) ? (double) r_ad->nb_same_var / r_ad->nb_iter : 0, r_ad->nb_iter_tot,
+		r_ad->nb_local_min_tot, r_ad->nb_swap_tot, r_ad->nb_reset_tot,
+		(r_ad->nb_iter_tot) ? (double) r_ad->nb_same_var_tot / r_ad->nb_iter_tot : 0,
+		run->max_rss);
+      else
+	fprintf(f, "%s,%d,%d,%d,%d,%d,%d,%.3f,%d,%d,%d,%d,%.2f,%d,%d,%d,%d,%.2f,%ld",
+		bench_name, p_ad->param, threads, i + 1, r_ad->seed, r_ad->total_cost,
+		r_ad->nb_restart, run->time,
+		r_ad->nb_iter, r_ad->nb_local_min, r_ad->nb_swap, r_ad->nb_reset,
+		(r_ad->nb_iter) ? (double) r_ad->nb_same_var / r_ad->nb_iter : 0, r_ad->nb_iter_tot,
+		r_ad->nb_local_min_tot, r_ad->nb_swap_tot, r_ad->nb_reset_tot,
+		(r_ad->nb_iter_tot) ? (double) r_ad->nb_same_var_tot / r_ad->nb_iter_tot : 0,
+		run->max_rss);
+
+      for(k = 0; hw_counters && k < HW_NB; k++)
+	if (json)
+	  fprintf(f, ", \"%s\": %lld", hw_name[k], run->hw[k]);
+	else
+	  fprintf(f, ",%lld", run->hw[k]);
+
+      if (json)
+	fprintf(f, " }%s\n", (i < nb_bench_run - 1) ? "," : "");
+      else
+	fprintf(f, "\n");
+    }
+
+  if (json)
+    fprintf(f, "  ],\n  \"summary\": {\n");
+
+  for(k = 0; k < NB_COLUMN; k++)
+    {
+      Percentiles(k, q);
+      if (json)
+	fprintf(f, "    \"%s\": { ", col_name[k]);
+      else
+	fprintf(f, "# %s", col_name[k]);
+
+      for(i = 0; i < 6; i++)
+	if (json)
+	  fprintf(f, "\"%s\": %.3f%s", q_name[i], q[i], (i < 5) ? ", " : "");
+	else
+	  fprintf(f, " %s=%.3f", q_name[i], q[i]);
+
+      if (json)
+	fprintf(f, " }%s\n", (k < NB_COLUMN - 1) ? "," : "");
+      else
+	fprintf(f, "\n");
+    }
+
+  if (json)
+    fprintf(f, "  }\n}\n");
+
+  fclose(f);
+}
+
+
+
+
+/*
+ *  BENCH_JOB
+ *
+ *  Runs the bench run no inside a worker (with its own seed).
+ */
+static void
+Bench_Job(int no, void *result)
+{
+  BenchRun *run = (BenchRun *) result;
+  AdData *p_ad = bench_ad;
+  double time_one0;
+
+  Set_Initial(p_ad);
+
+  p_ad->seed = bench_seed[no];
+  Randomize_Seed(p_ad->seed);
+  alarm(time_limit);
+  if (hw_counters)
+    Hw_Start();
+  time_one0 = (double) Run_Time();
+  Solve(p_ad);
+  run->time = ((double) Run_Time() - time_one0) / 1000;
+  Hw_Stop(run->hw);
+  Telemetry_Stop();		/* the worker ends with _exit() */
+
+  Verify_Sol(p_ad);
+
+  run->max_rss = Max_RSS();
+  run->ad = *p_ad;
+}
+
+
+
+
+/*
+ *  BENCH_PARALLEL
+ *
+ *  Spreads the bench runs over a pool of worker processes. The seed of
+ *  each run is drawn here (in order) so a bench only depends on -s.
+ *  Counters are only accumulated by this process as results arrive.
+ */
+static void
+Bench_Parallel(AdData *p_ad)
+{
+  BenchRun run;
+  int *sol = p_ad->sol;
+  int i, no, ret;
+
+  bench_ad = p_ad;
+  bench_seed = (int *) malloc(count * sizeof(int));
+  if (bench_seed == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  for(i = 0; i < count; i++)
+    bench_seed[i] = Random(65536);
+
+  Multi_Start(nb_workers, count, sizeof(run), Bench_Job);
+
+  i = 0;
+  while((ret = Multi_Next(&run, &no)) >= 0)
+    {
+      if (ret == 0)
+	{
+	  fprintf(stderr, "bench run %d (seed %d): worker terminated without result\n\n\n",
+		  no + 1, bench_seed[no]);
+	  continue;
+	}
+
+      *p_ad = run.ad;
+      p_ad->sol = sol;
+      Bench_Record(++i, p_ad, run.time, run.max_rss, run.hw);
+    }
+
+  Multi_Stop();
+  free(bench_seed);
+}
+
+
+
+
+/*
+ *  RUN_TIME
+ *
+ *  Returns the time used to measure a run (in msecs). Real time is used
+ *  when the run is performed by other processes (portfolio).
+ */
+static long
+Run_Time(void)
+{
+  return (nb_portfolio > 0) ? Real_Time() : User_Time();
+}
+
+
+
+
+/*
+ *  ADD_PORTFOLIO
+ *
+ *  Adds a configuration (a string of tuning options) to the portfolio.
+ */
+static void
+Add_Portfolio(char *conf)
+{
+  portfolio = (char **) realloc(portfolio, (nb_portfolio + 1) * sizeof(char *));
+  if (portfolio == NULL || (conf = strdup(conf)) == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  portfolio[nb_portfolio++] = conf;
+}
+
+
+
+
+/*
+ *  READ_PORTFOLIO
+ *
+ *  Reads configurations from a file (one per line, # starts a comment).
+ */
+static void
+Read_Portfolio(char *file_name)
+{
+  FILE *f;
+  char line[1024];
+  char *p, *q;
+
+  if ((f = fopen(file_name, "r")) == NULL)
+    {
+      perror(file_name);
+      exit(1);
+    }
+
+  while(fgets(line, sizeof(line), f))
+    {
+      if ((p = strchr(line, '#')) != NULL)
+	*p = '\0';
+
+      for(p = line; *p == ' ' || *p == '\t'; p++)
+	;
+      for(q = p + strlen(p); q > p && (q[-1] == '\n' || q[-1] == '\r' ||
+				       q[-1] == ' ' || q[-1] == '\t'); q--)
+	;
+      *q = '\0';
+
+      if (*p)
+	Add_Portfolio(p);
+    }
+
+  fclose(f);
+}
+
+
+
+
+/*
+ *  PORTFOLIO_PARAMS
+ *
+ *  Sets the tuning parameters of p_ad to the kth configuration (applied
+ *  over the default parameters). The data of the run itself are kept.
+ */
+static void
+Portfolio_Params(int k, AdData *p_ad)
+{
+  AdData ad = portfolio_base;
+  char buff[1024];
+  char *tok[256];
+  int n = 0, i, used;
+
+  ad.sol = p_ad->sol;
+  ad.seed = p_ad->seed;
+  ad.do_not_init = p_ad->do_not_init;
+  ad.reset_percent = -1;
+
+  strncpy(buff, portfolio[k], sizeof(buff) - 1);
+  buff[sizeof(buff) - 1] = '\0';
+  for(tok[n] = strtok(buff, " \t"); tok[n] && n < 255; tok[++n] = strtok(NULL, " \t"))
+    ;
+
+  for(i = 0; i < n; i += used)
+    {
+      used = (tok[i][0] == '-') ? Parse_Tuning_Option(tok[i], tok[i + 1], &ad) : 0;
+      if (used == 0)
+	{
+	  fprintf(stderr, "configuration %d: unrecognized tuning option %s\n", k + 1, tok[i]);
+	  exit(1);
+	}
+    }
+
+  if (ad.reset_percent >= 0)
+    ad.nb_var_to_reset = Div_Round_Up(ad.size * ad.reset_percent, 100);
+  else
+    ad.reset_percent = portfolio_base.reset_percent;
+
+  if (ad.reset_limit >= ad.size)
+    ad.reset_limit = ad.size - 1;
+
+  *p_ad = ad;
+}
+
+
+
+
+/*
+ *  PORTFOLIO_JOB
+ *
+ *  Runs the kth configuration inside a worker. The result is the AdData
+ *  followed by the (pseudo) solution.
+ */
+static void
+Portfolio_Job(int k, void *result)
+{
+  AdData *p_ad = portfolio_ad;
+
+  Portfolio_Params(k, p_ad);
+  p_ad->seed += k;
+  Randomize_Seed(p_ad->seed);
+
+  Solve(p_ad);
+  Telemetry_Stop();
+
+  memcpy(result, p_ad, sizeof(AdData));
+  memcpy((char *) result + sizeof(AdData), p_ad->sol, p_ad->size_in_bytes);
+}
+
+
+
+
+/*
+ *  PORTFOLIO_SOLVE
+ *
+ *  Runs one walker per configuration, the first solution wins (the other
+ *  walkers are then killed). If no walker succeeds the best pseudo-solution
+ *  is kept. Same interface as Solve().
+ */
+static void
+Portfolio_Solve(AdData *p_ad)
+{
+  int size = sizeof(AdData) + p_ad->size_in_bytes;
+  char *result = (char *) malloc(size);
+  AdData *r_ad = (AdData *) result;
+  int *sol = p_ad->sol;
+  int no, ret;
+
+  if (result == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  portfolio_ad = p_ad;
+  portfolio_winner = -1;
+
+  Multi_Start(nb_portfolio, nb_portfolio, size, Portfolio_Job);
+
+  while((ret = Multi_Next(result, &no)) >= 0)
+    {
+      if (ret == 0 || (portfolio_winner >= 0 && r_ad->total_cost >= p_ad->total_cost))
+	continue;
 
-  double time_one0, time_one;
-  double nb_same_var_by_iter, nb_same_var_by_iter_tot;
+      portfolio_winner = no;
+      *p_ad = *r_ad;
+      p_ad->sol = sol;
+      memcpy(sol, result + sizeof(AdData), p_ad->size_in_bytes);
 
-  int nb_iter_cum;
-  int nb_local_min_cum;
-  int nb_swap_cum;
-  int nb_reset_cum;
-  double nb_same_var_by_iter_cum;
+      if (p_ad->total_cost == 0)
+	break;
+    }
 
-  int nb_restart_cum,                nb_restart_min,              nb_restart_max;
-  double time_cum,                   time_min,                    time_max;
+  Multi_Stop();
+  free(result);
 
-  int nb_iter_tot_cum,               nb_iter_tot_min,             nb_iter_tot_max;
-  int nb_local_min_tot_cum,          nb_local_min_tot_min,        nb_local_min_tot_max;
-  int nb_swap_tot_cum,               nb_swap_tot_min,             nb_swap_tot_max;
-  int nb_reset_tot_cum,              nb_reset_tot_min,            nb_reset_tot_max;
-  double nb_same_var_by_iter_tot_cum, nb_same_var_by_iter_tot_min, nb_same_var_by_iter_tot_max;
+  if (portfolio_winner >= 0 && p_ad->total_cost == 0)
+    portfolio_wins[portfolio_winner]++;
+}
 
 
-  char buff[256];
 
-  Parse_Cmd_Line(argc, argv, p_ad);
 
-  if (p_ad->seed < 0)
-    p_ad->seed = Randomize();
-  else
-    Randomize_Seed(p_ad->seed);
+/*
+ *  INIT_DATA
+ *
+ *  Initializes the data of the problem (after the command-line is parsed).
+ */
+static void
+Init_Data(AdData *p_ad)
+{
+  int unit = p_ad->restart_limit;
+
+  if (p_ad->restart_policy != AD_RESTART_FIXED && p_ad->restart_max == -1)
+    p_ad->restart_max = (1 << 30);
 
   p_ad->nb_var_to_reset = -1;
   p_ad->do_not_init = 0;
@@ -123,244 +1420,222 @@ main(int argc, char *argv[])
   if (p_ad->reset_limit >= p_ad->size)
     p_ad->reset_limit = p_ad->size - 1;
 
-  setvbuf(stdout, NULL, _IOLBF, 0);
-  //setlinebuf(stdout);
-
-  if (p_ad->debug > 0 && !ad_has_debug)
-    printf("Warning ad_solver is not compiled with debugging support\n");
-
-  if (p_ad->log_file && !ad_has_log_file)
-    printf("Warning ad_solver is not compiled with log file support\n");
+  if (p_ad->restart_policy != AD_RESTART_FIXED && unit == -1)
+    p_ad->restart_limit = 10 * p_ad->size;
 
   p_ad->size_in_bytes = p_ad->size * sizeof(int);
   p_ad->sol = malloc(p_ad->size_in_bytes);
+  if (p_ad->sol == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
 
   if (p_ad->nb_var_to_reset == -1)
     p_ad->nb_var_to_reset = Div_Round_Up(p_ad->size * p_ad->reset_percent, 100);
+}
 
-  printf("current random seed used: %d\n", p_ad->seed);
-  printf("variables of loc min are frozen for: %d swaps\n", p_ad->freeze_loc_min);
-  printf("variables swapped    are frozen for: %d swaps\n", p_ad->freeze_swap);
-  if (p_ad->reset_percent >= 0)
-    printf("%d %% = ", p_ad->reset_percent);
-  printf("%d variables are reset when %d variables are frozen\n", 
-	 p_ad->nb_var_to_reset, p_ad->reset_limit);
-  printf("probability to select a local min (instead of staying on a plateau): ");
-  if (p_ad->prob_select_loc_min >=0 && p_ad->prob_select_loc_min <= 100)
-    printf("%d %%\n", p_ad->prob_select_loc_min);
-  else
-    printf("not used\n");
-  printf("abort when %d iterations are reached "
-	 "and restart at most %d times\n",
-	 p_ad->restart_limit, p_ad->restart_max);
-
-  if (count <= 0)
-    {
-      Set_Initial(p_ad);
-
-      p_ad->seed = Random(65536);
-      time_one0 = (double) User_Time();
-      Solve(p_ad);
-      time_one = ((double) User_Time() - time_one0) / 1000;
-
-      if (p_ad->exhaustive)
-	printf("exhaustive search\n");
 
-      if (count < 0)
-	Display_Solution(p_ad);
 
-      Verify_Sol(p_ad);
 
-      if (p_ad->total_cost)
-	printf("*** NOT SOLVED (cost of this pseudo-solution: %d) ***\n", p_ad->total_cost);
+/*
+ *  TUNE_JOB
+ *
+ *  Runs a configuration of the tuner on a seed inside a worker. Since the
+ *  param changes, the problem is initialized here (quietly).
+ */
+static void
+Tune_Job(int no, void *result)
+{
+  BenchRun *run = (BenchRun *) result;
+  TuneJob *job = tune_job + no;
+  AdData *p_ad = portfolio_ad;
+  double time_one0;
 
-      if (count == 0)
-	{
-	  nb_same_var_by_iter = (double) p_ad->nb_same_var / p_ad->nb_iter;
-	  nb_same_var_by_iter_tot = (double) p_ad->nb_same_var_tot / p_ad->nb_iter_tot;
+  if (freopen("/dev/null", "w", stdout) == NULL) /* avoid gcc warning warn_unused_result */
+    {}
 
-	  printf("%5d %7.2f %7d %7d %7d %7d %7.1f %7d %7d %7d %7d %7.1f\n", 
-		 p_ad->nb_restart, time_one, 
-		 p_ad->nb_iter, p_ad->nb_local_min, p_ad->nb_swap, 
-		 p_ad->nb_reset, nb_same_var_by_iter,
-		 p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot, 
-		 p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
-	}
-      else
-	{
-	  printf("in %.2f secs (%d iters, %d swaps, %d restarts)\n", 
-		 time_one, p_ad->nb_iter_tot, p_ad->nb_swap_tot, p_ad->nb_restart);
-	}
+  *p_ad = tune_cmd_line;
+  p_ad->param = tune_param;
+  Init_Data(p_ad);
 
-      return 0;
-    }
+  portfolio_base = *p_ad;
+  Portfolio_Params(job->conf, p_ad);
 
-  putchar('\n');
+  p_ad->seed = tune_seed[job->seed_no];
+  Randomize_Seed(p_ad->seed);
 
-  sprintf(buff, "|Count|restart|    time |   iters | loc min |   swaps "
-	  "|  resets |same/iter|\n");
+  alarm(time_limit);
+  time_one0 = (double) User_Time();
+  Solve(p_ad);
+  run->time = ((double) User_Time() - time_one0) / 1000;
+  Telemetry_Stop();
 
-  if (param_needed)
-    printf("%*d\n", (int) strlen(buff)/2, p_ad->param);
-  
-  printf("%s", buff);
-  for(i = 0; buff[i] != '\n'; i++)
-    if (buff[i] != '|')
-      buff[i] = '-';
-  printf("%s", buff);
-  printf("\n\n");
+  run->ad = *p_ad;
+}
 
-  
-  nb_restart_cum = time_cum = 0;
 
-  nb_iter_cum = nb_local_min_cum = nb_swap_cum = nb_reset_cum = 0;
-  nb_same_var_by_iter_cum = 0;
 
 
-  nb_iter_tot_cum = nb_local_min_tot_cum = nb_swap_tot_cum = nb_reset_tot_cum = 0;
-  nb_same_var_by_iter_tot_cum = 0;
+/*
+ *  TUNE
+ *
+ *  Races the configurations of the portfolio on each param with successive
+ *  halving: all configurations are run on a few seeds, the best half is
+ *  kept and the survivors are run on twice more seeds, until one remains
+ *  (or all seeds are used). The score of a configuration is its average
+ *  time, an unsolved run (not solved or killed at the time limit) counts
+ *  10 times the time limit (ties are broken on the nb of iterations).
+ *  Displays the table of the best parameters for each param.
+ */
+static void
+Tune(AdData *p_ad)
+{
+  int nb_conf = nb_portfolio;
+  int nb_seed = (count > 0) ? count : 16;
+  int *alive, *nb_done, *nb_solved;
+  double *score, *iters;
+  AdData *conf_ad;
+  BenchRun run;
+  char *p;
+  int nb_job, nb_alive, nb_run, nb_keep;
+  int i, j, k, no, ret, best;
+  double penalty;
+
+  if (nb_conf < 1)
+    {
+      fprintf(stderr, "-T needs configurations to race (-w/-W)\n");
+      exit(1);
+    }
 
-  nb_restart_min = (1 << 30);
-  time_min = 1e100;
-  
-  nb_iter_tot_min = nb_local_min_tot_min = nb_swap_tot_min = nb_reset_tot_min = (1 << 30);
-  nb_same_var_by_iter_tot_min = 1e100;
+  if (time_limit <= 0)
+    time_limit = 60;
+  penalty = 10.0 * time_limit;
+
+  alive = (int *) malloc(nb_conf * sizeof(int));
+  nb_done = (int *) malloc(nb_conf * sizeof(int));
+  nb_solved = (int *) malloc(nb_conf * sizeof(int));
+  score = (double *) malloc(nb_conf * sizeof(double));
+  iters = (double *) malloc(nb_conf * sizeof(double));
+  conf_ad = (AdData *) calloc(nb_conf, sizeof(AdData)); /* size 0 = not known */
+  tune_seed = (int *) malloc(nb_seed * sizeof(int));
+  tune_job = (TuneJob *) malloc(nb_conf * nb_seed * sizeof(TuneJob));
+  portfolio_ad = (AdData *) malloc(sizeof(AdData));
+  if (alive == NULL || nb_done == NULL || nb_solved == NULL || score == NULL || iters == NULL ||
+      conf_ad == NULL || tune_seed == NULL || tune_job == NULL || portfolio_ad == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
 
-  nb_restart_max = 0;
-  time_max = 0;
- 
-  nb_iter_tot_max = nb_local_min_tot_max = nb_swap_tot_max = nb_reset_tot_max = 0;
-  nb_same_var_by_iter_tot_max = 0;
+  tune_cmd_line = *p_ad;
 
+  for(j = 0; j < nb_seed; j++)
+    tune_seed[j] = Random(65536);
 
-  for(i = 1; i <= count; i++)
-    {
-      Set_Initial(p_ad);
+  for(k = 0; (1 << k) < nb_conf; k++) /* nb of halvings */
+    ;
 
-      p_ad->seed = Random(65536);
-      time_one0 = (double) User_Time();
-      Solve(p_ad);
-      time_one = ((double) User_Time() - time_one0) / 1000;
+#define Tune_Worse(i, j) (score[i] > score[j] || (score[i] == score[j] && iters[i] > iters[j]))
 
-      if (disp_mode == 2 && nb_restart_cum > 0)
-	printf("\033[A\033[K");
-      printf("\033[A\033[K\033[A\033[256D");
+  printf("tuning %d configurations by successive halving\n", nb_conf);
+  printf("up to %d seeds per param, %d processes, time limit: %d secs (unsolved runs count %g secs)\n",
+	 nb_seed, (nb_workers <= 0) ? Multi_Nb_Cpus() : nb_workers, time_limit, penalty);
+  for(i = 0; i < nb_conf; i++)
+    printf("  %3d: %s\n", i + 1, portfolio[i]);
 
+  printf("\n| param |  runs solved |    score | conf |     P |     f |     F |     l |     p |        a |       r |\n");
 
-      Verify_Sol(p_ad);
+  for(p = tune_params; *p; )
+    {
+      tune_param = strtol(p, &p, 10);
+      while(*p == ',' || *p == ' ')
+	p++;
 
-      nb_same_var_by_iter = (double) p_ad->nb_same_var / p_ad->nb_iter;
-      nb_same_var_by_iter_tot = (double) p_ad->nb_same_var_tot / p_ad->nb_iter_tot;
-
-      nb_restart_cum += p_ad->nb_restart;
-      time_cum += time_one;
-      nb_iter_cum += p_ad->nb_iter;
-      nb_local_min_cum += p_ad->nb_local_min;
-      nb_swap_cum += p_ad->nb_swap;
-      nb_reset_cum += p_ad->nb_reset;
-      nb_same_var_by_iter_cum += nb_same_var_by_iter;
-
-      nb_iter_tot_cum += p_ad->nb_iter_tot;
-      nb_local_min_tot_cum += p_ad->nb_local_min_tot;
-      nb_swap_tot_cum += p_ad->nb_swap_tot;
-      nb_reset_tot_cum += p_ad->nb_reset_tot;
-      nb_same_var_by_iter_tot_cum += nb_same_var_by_iter_tot;
-
-      if (nb_restart_min > p_ad->nb_restart)
-	nb_restart_min = p_ad->nb_restart;
-      if (time_min > time_one)
-	time_min = time_one;
-      if (nb_iter_tot_min > p_ad->nb_iter_tot)
-	nb_iter_tot_min = p_ad->nb_iter_tot;
-      if (nb_local_min_tot_min > p_ad->nb_local_min_tot)
-	nb_local_min_tot_min = p_ad->nb_local_min_tot;
-      if (nb_swap_tot_min > p_ad->nb_swap_tot)
-	nb_swap_tot_min = p_ad->nb_swap_tot;
-      if (nb_reset_tot_min > p_ad->nb_reset_tot)
-	nb_reset_tot_min = p_ad->nb_reset_tot;
-      if (nb_same_var_by_iter_tot_min > nb_same_var_by_iter_tot)
-	nb_same_var_by_iter_tot_min = nb_same_var_by_iter_tot;
-
-      if (nb_restart_max < p_ad->nb_restart)
-	nb_restart_max = p_ad->nb_restart;
-      if (time_max < time_one)
-	time_max = time_one;
-      if (nb_iter_tot_max < p_ad->nb_iter_tot)
-	nb_iter_tot_max = p_ad->nb_iter_tot;
-      if (nb_local_min_tot_max < p_ad->nb_local_min_tot)
-	nb_local_min_tot_max = p_ad->nb_local_min_tot;
-      if (nb_swap_tot_max < p_ad->nb_swap_tot)
-	nb_swap_tot_max = p_ad->nb_swap_tot;
-      if (nb_reset_tot_max < p_ad->nb_reset_tot)
-	nb_reset_tot_max = p_ad->nb_reset_tot;
-      if (nb_same_var_by_iter_tot_max < nb_same_var_by_iter_tot)
-	nb_same_var_by_iter_tot_max = nb_same_var_by_iter_tot;
-
-
-      switch(disp_mode)
+      for(i = 0; i < nb_conf; i++)
 	{
-	case 0:			/* only last iter counters */
-	case 2:			/* last iter followed by restart if needed */
-	  printf("|%4d | %5d%c| %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-		 i, p_ad->nb_restart, (p_ad->total_cost == 0) ? ' ' : 'N', time_one,
-		 p_ad->nb_iter, p_ad->nb_local_min, p_ad->nb_swap,
-		 p_ad->nb_reset, nb_same_var_by_iter);
-
-	  if (disp_mode == 2 && p_ad->nb_restart > 0)
-	    printf("|     |       |         | %7d | %7d | %7d | %7d | %7.1f |\n",
-		   p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot,
-		   p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
-
-	  printf("%s", buff);
-
-	  printf("| avg | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-		 nb_restart_cum / i, time_cum / i,
-		 nb_iter_cum / i, nb_local_min_cum / i, nb_swap_cum / i,
-		 nb_reset_cum / i, nb_same_var_by_iter_cum / i);
-
-	  if (disp_mode == 2 && nb_restart_cum > 0)
-	    printf("|     |       |         | %7d | %7d | %7d | %7d | %7.1f |\n",
-		   nb_iter_tot_cum / i, nb_local_min_tot_cum / i, nb_swap_tot_cum / i,
-		   nb_reset_tot_cum / i, nb_same_var_by_iter_tot_cum / i);
-
-	  break;
-
-	case 1:			/* only total (restart + last iter) counters */
-	  printf("|%4d | %5d%c| %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-		 i, p_ad->nb_restart, (p_ad->total_cost == 0) ? ' ' : 'N', time_one,
-		 p_ad->nb_iter_tot, p_ad->nb_local_min_tot, p_ad->nb_swap_tot,
-		 p_ad->nb_reset_tot, nb_same_var_by_iter_tot);
+	  alive[i] = 1;
+	  conf_ad[i].size = 0;
+	  nb_done[i] = nb_solved[i] = 0;
+	  score[i] = iters[i] = 0;
+	}
 
-	  printf("%s", buff);
+      nb_alive = nb_conf;
+      nb_run = nb_seed >> k;
+      if (nb_run < 1)
+	nb_run = 1;
 
-	  printf("| avg | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-		 nb_restart_cum / i, time_cum / i,
-		 nb_iter_tot_cum / i, nb_local_min_tot_cum / i, nb_swap_tot_cum / i,
-		 nb_reset_tot_cum / i, nb_same_var_by_iter_tot_cum / i);
-	  break;
-	}
-    }
+      for(;;)
+	{
+	  nb_job = 0;
+	  for(i = 0; i < nb_conf; i++)
+	    for(j = nb_done[i]; alive[i] && j < nb_run; j++)
+	      {
+		tune_job[nb_job].conf = i;
+		tune_job[nb_job].seed_no = j;
+		nb_job++;
+	      }
+
+	  Multi_Start(nb_workers, nb_job, sizeof(run), Tune_Job);
+	  while((ret = Multi_Next(&run, &no)) >= 0)
+	    {
+	      i = tune_job[no].conf;
+	      if (ret == 1 && run.ad.total_cost == 0)
+		{
+		  score[i] += run.time;
+		  nb_solved[i]++;
+		}
+	      else
+		score[i] += penalty;
+	      if (ret == 1)
+		{
+		  iters[i] += run.ad.nb_iter_tot;
+		  conf_ad[i] = run.ad;
+		}
+	    }
+	  Multi_Stop();
 
-  if (count <= 0)
-    return 0;
+	  for(i = 0; i < nb_conf; i++)
+	    if (alive[i])
+	      nb_done[i] = nb_run;
 
-  printf("| min | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-	 nb_restart_min, time_min,
-	 nb_iter_tot_min, nb_local_min_tot_min, nb_swap_tot_min,
-	 nb_reset_tot_min, nb_same_var_by_iter_tot_min);
+	  if (nb_alive == 1 || nb_run >= nb_seed)
+	    break;
 
-  printf("| max | %5d | %7.2f | %7d | %7d | %7d | %7d | %7.1f |\n",
-	 nb_restart_max, time_max,
-	 nb_iter_tot_max, nb_local_min_tot_max, nb_swap_tot_max,
-	 nb_reset_tot_max, nb_same_var_by_iter_tot_max);
+	  nb_keep = (nb_alive + 1) / 2; /* kill the worst ones */
+	  while(nb_alive > nb_keep)
+	    {
+	      for(best = -1, i = 0; i < nb_conf; i++)
+		if (alive[i] && (best < 0 || Tune_Worse(i, best)))
+		  best = i;
+	      alive[best] = 0;
+	      nb_alive--;
+	    }
 
+	  nb_run *= 2;
+	  if (nb_run > nb_seed)
+	    nb_run = nb_seed;
+	}
 
+      for(best = -1, i = 0; i < nb_conf; i++)
+	if (alive[i] && (best < 0 || Tune_Worse(best, i)))
+	  best = i;
 
-  return 0;
+      AdData *b_ad = conf_ad + best;
+      printf("| %5d | %5d %5d  | %8.3f | %4d |", tune_param, nb_done[best], nb_solved[best],
+	     score[best] / nb_done[best], best + 1);
+      if (b_ad->size == 0)	/* no run terminated: parameters not known */
+	printf("     - |     - |     - |     - |     - |        - |       - |\n");
+      else
+	printf(" %5d | %5d | %5d | %5d | %5d | %8d | %7d |\n",
+	       b_ad->prob_select_loc_min, b_ad->freeze_loc_min, b_ad->freeze_swap,
+	       b_ad->reset_limit, b_ad->reset_percent, b_ad->restart_limit, b_ad->restart_max);
+    }
 }
 
 
 
+
 void
 Set_Initial(AdData *p_ad)
 {
@@ -430,6 +1705,171 @@ Verify_Sol(AdData *p_ad)
 
 #define L(msg) fprintf(stderr, msg "\n")
 
+#define Arg_Expected(msg)			\
+  if (arg == NULL)				\
+    {						\
+      L(msg);					\
+      exit(1);					\
+    }
+
+
+/*
+ *  PARSE_RESTART_POLICY
+ *
+ *  Parses POLICY[:UNIT[:RATIO]] (see -R). UNIT overwrites the restart limit.
+ */
+static void
+Parse_Restart_Policy(char *arg, AdData *p_ad)
+{
+  static char *name[] = { "fixed", "luby", "geom", "stag" };
+  char *p = strchr(arg, ':');
+  int n = (p) ? p - arg : (int) strlen(arg);
+  int k;
+
+  for(k = 0; k < 4 && (strncmp(arg, name[k], n) != 0 || name[k][n] != '\0'); k++)
+    ;
+  if (k == 4)
+    {
+      fprintf(stderr, "unknown restart policy %s (fixed, luby, geom or stag)\n", arg);
+      exit(1);
+    }
+  p_ad->restart_policy = k;
+
+  if (p == NULL)
+    return;
+
+  p_ad->restart_limit = strtol(p + 1, &p, 10);
+  if (*p == ':')
+    p_ad->restart_factor = strtod(p + 1, &p) * 100;
+
+  if (*p != '\0' || p_ad->restart_limit <= 0 || p_ad->restart_factor <= 100)
+    {
+      fprintf(stderr, "bad restart policy argument %s\n", arg);
+      exit(1);
+    }
+}
+
+
+
+
+/*
+ *  PARSE_RESET_STRATEGY
+ *
+ *  Parses the name of a reset strategy (see -k).
+ */
+static void
+Parse_Reset_Strategy(char *arg, AdData *p_ad)
+{
+  static char *name[] = { "random", "worst", "frozen" };
+  int k;
+
+  for(k = 0; k < 3 && strcmp(arg, name[k]) != 0; k++)
+    ;
+  if (k == 3)
+    {
+      fprintf(stderr, "unknown reset strategy %s (random, worst or frozen)\n", arg);
+      exit(1);
+    }
+  p_ad->reset_strategy = k;
+}
+
+
+
+
+/*
+ *  PARSE_TUNING_OPTION
+ *
+ *  Parses a tuning option (also used for the configurations of a portfolio).
+ *  Returns the nb of arguments consumed (option included) or 0 if unknown.
+ */
+static int
+Parse_Tuning_Option(char *opt, char *arg, AdData *p_ad)
+{
+  switch(opt[1])
+    {
+    case 'e':
+      p_ad->exhaustive = 1;
+      return 1;
+
+    case 'P':
+      Arg_Expected("probability (in %%) expected");
+      p_ad->prob_select_loc_min = atoi(arg);
+      return 2;
+
+    case 'f':
+      Arg_Expected("freeze number expected");
+      p_ad->freeze_loc_min = atoi(arg);
+      return 2;
+
+    case 'F':
+      Arg_Expected("freeze number expected");
+      p_ad->freeze_swap = atoi(arg);
+      return 2;
+
+    case 'l':
+      Arg_Expected("reset limit expected");
+      p_ad->reset_limit = atoi(arg);
+      return 2;
+
+    case 'p':
+      Arg_Expected("reset percent expected");
+      p_ad->reset_percent = atoi(arg);
+      return 2;
+
+    case 'k':
+      Arg_Expected("reset strategy expected");
+      Parse_Reset_Strategy(arg, p_ad);
+      return 2;
+
+    case 'z':
+      Arg_Expected("tabu window expected");
+      p_ad->tabu_window = atoi(arg);
+      return 2;
+
+    case 'y':
+      Arg_Expected("decay period expected");
+      p_ad->weight_decay = atoi(arg);
+      return 2;
+
+    case 'E':
+      Arg_Expected("number of partners expected");
+      p_ad->compound_moves = atoi(arg);
+      return 2;
+
+    case 'Z':
+      Arg_Expected("cost threshold expected");
+      p_ad->endgame_cost = atoi(arg);
+      return 2;
+
+    case 'm':
+      Arg_Expected("number of swaps expected");
+      p_ad->multi_swap = atoi(arg);
+      return 2;
+
+    case 'a':
+      Arg_Expected("restart limit expected");
+      p_ad->restart_limit = atoi(arg);
+      return 2;
+
+    case 'r':
+      Arg_Expected("restart number expected");
+      p_ad->restart_max = atoi(arg);
+      return 2;
+
+    case 'R':
+      Arg_Expected("restart policy expected");
+      Parse_Restart_Policy(arg, p_ad);
+      return 2;
+
+    case 'A':
+      Arg_Expected("adaptation window expected");
+      p_ad->adapt_window = atoi(arg);
+      return 2;
+    }
+
+  return 0;
+}
+
 
 /*
  *  PARSE_CMD_LINE
@@ -438,14 +1878,18 @@ Verify_Sol(AdData *p_ad)
 static void
 Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 {
-  int i;
+  int i, k;
 
   nb_threads = 1;
 
+  bench_name = strrchr(argv[0], '/');
+  bench_name = (bench_name) ? bench_name + 1 : argv[0];
+
   count = -1;
   disp_mode = 1;
   check_valid = 0;
   read_initial = 0;
+  nb_workers = 1;
 
   p_ad->param = -1;
   p_ad->seed = -1;
@@ -458,6 +1902,8 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
   p_ad->reset_percent = -1;
   p_ad->restart_limit = -1;
   p_ad->restart_max = -1;
+  p_ad->restart_policy = AD_RESTART_FIXED;
+  p_ad->restart_factor = 150;
   p_ad->exhaustive = 0;
   p_ad->first_best = 0;
 
@@ -503,10 +1949,6 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      check_valid = 1;
 	      continue;
 
-	    case 'e':
-	      p_ad->exhaustive = 1;
-	      continue;
-
 	    case 'b':
 	      if (++i >= argc)
 		{
@@ -516,6 +1958,60 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      count = atoi(argv[i]);
 	      continue;
 
+	    case 'j':
+	      if (++i >= argc)
+		{
+		  L("number of workers expected");
+		  exit(1);
+		}
+	      nb_workers = atoi(argv[i]);
+	      continue;
+
+	    case 'w':
+	      if (++i >= argc)
+		{
+		  L("configuration expected");
+		  exit(1);
+		}
+	      Add_Portfolio(argv[i]);
+	      continue;
+
+	    case 'W':
+	      if (++i >= argc)
+		{
+		  L("configuration file name expected");
+		  exit(1);
+		}
+	      Read_Portfolio(argv[i]);
+	      continue;
+
+	    case 'x':
+	      if (++i >= argc)
+		{
+		  L("time limit expected");
+		  exit(1);
+		}
+	      time_limit = atoi(argv[i]);
+	      continue;
+
+	    case 'o':
+	      if (++i >= argc)
+		{
+		  L("output file expected");
+		  exit(1);
+		}
+	      out_file = argv[i];
+	      continue;
+
+	    case 'T':
+	      if (++i >= argc)
+		{
+		  L("list of params expected");
+		  exit(1);
+		}
+	      tune_params = argv[i];
+	      continue;
+
 	    case 'd':
 	      if (++i >= argc)
 		{
@@ -525,67 +2021,79 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      disp_mode = atoi(argv[i]);
 	      continue;
 
-	    case 'P':
+	    case 'H':
+	      hw_counters = 1;
+	      continue;
+
+	    case 'V':
 	      if (++i >= argc)
 		{
-		  L("probability (in %%) expected");
+		  L("number of iterations or probability expected");
 		  exit(1);
 		}
-	      p_ad->prob_select_loc_min = atoi(argv[i]);
+	      if (argv[i][strlen(argv[i]) - 1] == '%')
+		p_ad->verify_ppm = (int) (atof(argv[i]) * 10000 + 0.5);
+	      else
+		p_ad->verify_interval = atoi(argv[i]);
 	      continue;
 
-	    case 'f':
+	    case 'n':
 	      if (++i >= argc)
 		{
-		  L("freeze number expected");
+		  L("number of solutions expected");
 		  exit(1);
 		}
-	      p_ad->freeze_loc_min = atoi(argv[i]);
+	      p_ad->nb_solutions = atoi(argv[i]);
+	      continue;
+
+	    case 'U':
+	      live_update = 1;
 	      continue;
 
-	    case 'F':
+	    case 'B':
 	      if (++i >= argc)
 		{
-		  L("freeze number expected");
+		  L("number of blocks expected");
 		  exit(1);
 		}
-	      p_ad->freeze_swap = atoi(argv[i]);
+	      p_ad->nb_blocks = atoi(argv[i]);
 	      continue;
 
-	    case 'l':
+	    case 'N':
 	      if (++i >= argc)
 		{
-		  L("reset limit expected");
+		  L("solution file name expected");
 		  exit(1);
 		}
-	      p_ad->reset_limit = atoi(argv[i]);
+	      sol_file = argv[i];
 	      continue;
 
-	    case 'p':
+	    case 'g':
 	      if (++i >= argc)
 		{
-		  L("reset percent expected");
+		  L("landscape file name expected");
 		  exit(1);
 		}
-	      p_ad->reset_percent = atoi(argv[i]);
+	      landscape_file = argv[i];
+	      p_ad->landscape = 1;
 	      continue;
 
-	    case 'a':
+	    case 'M':
 	      if (++i >= argc)
 		{
-		  L("restart limit expected");
+		  L("number of iterations expected");
 		  exit(1);
 		}
-	      p_ad->restart_limit = atoi(argv[i]);
+	      p_ad->stat_interval = atoi(argv[i]);
 	      continue;
 
-	    case 'r':
+	    case 'K':
 	      if (++i >= argc)
 		{
-		  L("restart number expected");
+		  L("number of calls expected");
 		  exit(1);
 		}
-	      p_ad->restart_max = atoi(argv[i]);
+	      p_ad->kbench_calls = atoi(argv[i]);
 	      continue;
 
 #ifdef CELL
@@ -611,10 +2119,12 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      L("");
 	      L("   -i          read initial position");
 	      L("   -D LEVEL    set debug mode (0=debug info, 1=step-by-step)");
-	      L("   -L FILE     use file as log file");
+	      L("   -L FILE     record a binary trace of the search in FILE (see trace-decode)");
 	      L("   -c          check if the solution is valid");
 	      L("   -s SEED     specify random seed");
 	      L("   -b COUNT    bench COUNT times");
+	      L("   -j NB       run the bench runs in NB parallel processes (0=nb of cpus)");
+	      L("   -o FILE     save each run and a summary in FILE (.json: JSON, else CSV)");
 	      L("   -d WHAT     set display info (needs -b), WHAT is:");
               L("                 0=only last iter counters, 1=sum of restart+last iter counters (default)");
 	      L("                 2=restart and last iter counters");
@@ -623,9 +2133,43 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      L("   -F NB       freeze variables swapped for NB swaps");
 	      L("   -l LIMIT    reset some variables when LIMIT variable are frozen");
 	      L("   -p PERCENT  reset PERCENT %% of variables");
+	      L("   -k STRATEGY variables to reset: random (default, then recompute the cost),");
+	      L("               worst (highest cost) or frozen (marked), swapped with random variables");
+	      L("   -z NB       refuse non-improving moves back to a configuration seen in the last NB swaps");
+	      L("   -m NB       up to NB non-interacting improving swaps per iteration (benches defining");
+	      L("               Swap_Footprint)");
+	      L("   -y NB       on a reset raise the weights of the violated constraints, halve them");
+	      L("               every NB raises (benches defining Violated_Constraints)");
+	      L("   -E NB       on a local min, first try the 3-cycles of its variable with NB partners");
+	      L("   -Z COST     on a local min of cost <= COST, first try a bounded search (a few swaps");
+	      L("               of the conflicting variables) for a solution");
 	      L("   -a NB       abort and restart when NB iterations are reached");
 	      L("   -r COUNT    restart at most COUNT times");
+	      L("   -R POLICY   restart policy: fixed, luby[:UNIT], geom[:UNIT[:RATIO]] or stag[:NB]");
+	      L("               luby: UNIT * luby(k) iters, geom: UNIT * RATIO^k iters (default 1.5),");
+	      L("               stag: NB iters without improvement (UNIT, NB default to -a or 10 * size)");
+	      L("               with a policy, restarts are not limited unless -r is given");
 	      L("   -e          exhaustive seach (do all combinations)");
+	      L("   -A NB       adapt the above parameters every NB iterations (reactive search)");
+	      L("   -w OPTIONS  add a configuration (tuning options, e.g. \"-P 6 -f 8\") to the portfolio");
+	      L("   -W FILE     add the configurations of FILE (one per line) to the portfolio");
+	      L("               each run then starts one walker per configuration (first solution wins)");
+	      L("   -T PARAMS   tune: race the portfolio configurations on each param of PARAMS (e.g. 30,40,50)");
+	      L("               using -b COUNT seeds at most (default 16) and -j processes");
+	      L("   -x SECS     kill a run performed by a worker process after SECS secs (-j, -T)");
+	      L("   -K NB       no search: time the cost functions on NB calls (random configuration)");
+	      L("   -M NB       publish a live status every NB iterations (see adstat)");
+	      L("   -H          count cycles, instructions, cache and branch misses of each run (perf)");
+	      L("   -V NB[%%]   check the incremental costs against Cost_Of_Solution every NB iterations");
+	      L("               (or with probability NB %%) and report the first divergence");
+	      L("   -n NB       go on after a solution until NB distinct solutions are found");
+	      L("   -N FILE     stream the solutions of -n in FILE (default stdout, .bin: int32 values)");
+	      L("   -B NB       first repair the configuration by rounds of NB disjoint blocks searched");
+	      L("               in parallel (one process each), for huge instances");
+	      L("   -U          live session: then read data changes on stdin and re-solve each time");
+	      L("               from the previous solution (benches defining Change_Data)");
+	      L("   -g FILE     write the distributions of plateau lengths, local min costs, ties and");
+	      L("               chosen variables (all runs) in FILE");
 	      L("   -h          show this help");
 #ifdef CELL
 	      L("");
@@ -636,6 +2180,11 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	      exit(0);
 
 	    default:
+	      if ((k = Parse_Tuning_Option(argv[i], (i + 1 < argc) ? argv[i + 1] : NULL, p_ad)) > 0)
+		{
+		  i += k - 1;
+		  continue;
+		}
 	      fprintf(stderr, "unrecognized option %s (-h for a help)\n", argv[i]);
 	      exit(1);
 	    }
@@ -649,7 +2198,49 @@ Parse_Cmd_Line(int argc, char *argv[], AdData *p_ad)
 	}
     }
 
-  if (param_needed && p_ad->param < 0)
+  if (nb_workers != 1 && read_initial == 1)
+    {
+      L("-j and -i cannot be used together");
+      exit(1);
+    }
+
+  if (nb_workers != 1 && nb_portfolio > 0 && tune_params == NULL)
+    {
+      L("-j and a portfolio (-w/-W) cannot be used together");
+      exit(1);
+    }
+
+  if (landscape_file && (nb_workers != 1 || nb_portfolio > 0 || tune_params))
+    {
+      L("-g cannot be used with -j, a portfolio (-w/-W) or -T (runs in other processes)");
+      exit(1);
+    }
+
+  if (p_ad->log_file && (nb_workers != 1 || nb_portfolio > 0 || tune_params || p_ad->nb_blocks > 1))
+    {
+      L("-L cannot be used with -j, a portfolio (-w/-W), -T or -B (runs in other processes)");
+      exit(1);
+    }
+
+  if (p_ad->nb_solutions > 1 && (count > 0 || nb_portfolio > 0 || tune_params))
+    {
+      L("-n cannot be used with -b, a portfolio (-w/-W) or -T");
+      exit(1);
+    }
+
+  if (live_update && (count > 0 || nb_portfolio > 0 || tune_params || p_ad->nb_solutions > 1))
+    {
+      L("-U cannot be used with -b, a portfolio (-w/-W), -T or -n");
+      exit(1);
+    }
+
+  if (live_update && ad_no_change_data_fct)
+    {
+      L("-U: this benchmark does not support changes of its data (no Change_Data)");
+      exit(1);
+    }
+
+  if (param_needed && p_ad->param < 0 && tune_params == NULL)
     {
       printf("param :");
       if (scanf("%d", &p_ad->param))	/* avoid gcc warning warn_unused_result */
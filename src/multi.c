@@ -0,0 +1,302 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  multi.c: pool of worker processes (multicore version of multi-walks)
+ *
+ *  The solver and the benchmarks keep their state in static variables,
+ *  so (as on the Cell where each SPU has its own copy) each job is run
+ *  in its own process. At most nb_workers processes run at the same time,
+ *  each one is forked for a single job and sends back its result through
+ *  a dedicated pipe. The end of file on this pipe tells the parent the
+ *  worker is gone (with or without a result).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "multi.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef struct
+{
+  pid_t pid;			/* pid of the worker (0 if the slot is free) */
+  int fd;			/* read end of its pipe */
+  int no;			/* job run by this worker */
+}Worker;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static Worker *worker;		/* the slots */
+static struct pollfd *poll_fd;	/* poll info for running workers */
+static int nb_slot;		/* nb of slots (max nb of workers) */
+static int nb_running;		/* nb of running workers */
+
+static int nb_job;		/* total nb of jobs */
+static int next_job;		/* next job to launch */
+static int res_size;		/* size of a result */
+static MultiJob job_fct;	/* function running a job */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Launch(Worker *w);
+
+static int Read_Result(int fd, void *result);
+
+
+
+
+/*
+ *  MULTI_NB_CPUS
+ *
+ *  Returns the number of online processors.
+ */
+int
+Multi_Nb_Cpus(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (n > 0) ? (int) n : 1;
+}
+
+
+
+
+/*
+ *  MULTI_START
+ *
+ *  Starts nb_jobs jobs on at most nb_workers processes (0 = nb of cpus).
+ *  Results (result_size bytes each) are then obtained with Multi_Next().
+ */
+void
+Multi_Start(int nb_workers, int nb_jobs, int result_size, MultiJob job)
+{
+  int i;
+
+  if (nb_workers <= 0)
+    nb_workers = Multi_Nb_Cpus();
+
+  if (nb_workers > nb_jobs)
+    nb_workers = nb_jobs;
+
+  nb_slot = nb_workers;
+  nb_running = 0;
+  nb_job = nb_jobs;
+  next_job = 0;
+  res_size = result_size;
+  job_fct = job;
+
+  worker = (Worker *) calloc(nb_slot + 1, sizeof(Worker));
+  poll_fd = (struct pollfd *) calloc(nb_slot + 1, sizeof(struct pollfd));
+  if (worker == NULL || poll_fd == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  for(i = 0; i < nb_slot; i++)
+    Launch(worker + i);
+}
+
+
+
+
+/*
+ *  LAUNCH
+ *
+ *  Forks a worker in the (free) slot w for the next pending job (if any).
+ */
+static void
+Launch(Worker *w)
+{
+  int fd[2];
+  pid_t pid;
+  char *result;
+
+  w->pid = 0;
+  if (next_job >= nb_job)
+    return;
+
+  if (pipe(fd) < 0)
+    {
+      perror("Multi_Start: pipe");
+      exit(1);
+    }
+
+  fflush(stdout);		/* avoid to duplicate pending output */
+  fflush(stderr);
+
+  if ((pid = fork()) < 0)
+    {
+      perror("Multi_Start: fork");
+      exit(1);
+    }
+
+  if (pid == 0)			/* the worker */
+    {
+      close(fd[0]);
+      if ((result = (char *) calloc(1, res_size)) == NULL)
+	_exit(1);
+
+      (*job_fct)(next_job, result);
+      fflush(stdout);
+
+      char *p = result;
+      int n = res_size, k;
+      while(n > 0 && ((k = write(fd[1], p, n)) > 0 || errno == EINTR))
+	if (k > 0)
+	  {
+	    p += k;
+	    n -= k;
+	  }
+      _exit(0);
+    }
+
+  close(fd[1]);
+  w->pid = pid;
+  w->fd = fd[0];
+  w->no = next_job++;
+  nb_running++;
+}
+
+
+
+
+/*
+ *  READ_RESULT
+ *
+ *  Reads a whole result (blocking). Returns 1 if OK, 0 on a premature end.
+ */
+static int
+Read_Result(int fd, void *result)
+{
+  char *p = (char *) result;
+  int n = res_size, k;
+
+  while(n > 0)
+    {
+      k = read(fd, p, n);
+      if (k < 0 && errno == EINTR)
+	continue;
+      if (k <= 0)
+	return 0;
+      p += k;
+      n -= k;
+    }
+
+  return 1;
+}
+
+
+
+
+/*
+ *  MULTI_NEXT
+ *
+ *  Waits for the next finished job and puts its number in *no.
+ *  Returns 1 if its result has been stored in result, 0 if the worker
+ *  terminated without result (killed, time limit,...) and -1 when
+ *  all jobs are finished. A pending job is launched in the freed slot.
+ */
+int
+Multi_Next(void *result, int *no)
+{
+  int i, n, ret;
+  Worker *w;
+
+  while(nb_running > 0)
+    {
+      for(i = n = 0; i < nb_slot; i++)
+	if (worker[i].pid)
+	  {
+	    poll_fd[n].fd = worker[i].fd;
+	    poll_fd[n].events = POLLIN;
+	    poll_fd[n].revents = 0;
+	    n++;
+	  }
+
+      if (poll(poll_fd, n, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror("Multi_Next: poll");
+	  exit(1);
+	}
+
+      for(i = n = 0; i < nb_slot; i++)
+	{
+	  w = worker + i;
+	  if (w->pid == 0)
+	    continue;
+
+	  if (poll_fd[n++].revents == 0)
+	    continue;
+
+	  ret = Read_Result(w->fd, result);
+	  close(w->fd);
+	  waitpid(w->pid, NULL, 0);
+	  nb_running--;
+	  *no = w->no;
+	  Launch(w);
+	  return ret;
+	}
+    }
+
+  return -1;
+}
+
+
+
+
+/*
+ *  MULTI_STOP
+ *
+ *  Kills all running workers (e.g. a solution has been found) and frees
+ *  the pool. Pending jobs are not launched.
+ */
+void
+Multi_Stop(void)
+{
+  int i;
+  Worker *w;
+
+  for(i = 0; i < nb_slot; i++)
+    {
+      w = worker + i;
+      if (w->pid == 0)
+	continue;
+
+      kill(w->pid, SIGKILL);
+      close(w->fd);
+      waitpid(w->pid, NULL, 0);
+      w->pid = 0;
+    }
+
+  nb_running = 0;
+  free(worker);
+  free(poll_fd);
+  worker = NULL;
+  poll_fd = NULL;
+}
@@ -0,0 +1,39 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  multi.h: pool of worker processes (multicore version of multi-walks)
+ */
+
+#ifndef MULTI_H
+#define MULTI_H 1
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef void (*MultiJob)(int no, void *result); /* run job no, fill result */
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+int Multi_Nb_Cpus(void);
+
+void Multi_Start(int nb_workers, int nb_jobs, int result_size, MultiJob job);
+
+int Multi_Next(void *result, int *no);
+
+void Multi_Stop(void);
+
+#endif /* !MULTI_H */
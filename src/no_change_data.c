@@ -0,0 +1,28 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  no_change_data.c: wrapper when user function Change_Data is not defined
+ */
+
+#include <stdio.h>
+
+#include "ad_solver.h"
+
+int
+Change_Data(char *change, AdData *p_ad)
+{
+  fprintf(stderr, "this benchmark does not support changes of its data\n");
+  return -1;
+}
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_change_data_fct = 1;
+}
@@ -0,0 +1,51 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  no_cost_cycle.c: wrapper when user function Cost_If_Cycle is not defined
+ *
+ *  The first swap is temporarily performed (and recorded with Executed_Swap)
+ *  to evaluate the second one with Cost_If_Swap. The swaps are passed as
+ *  i < j (as Next_I/Next_J do).
+ */
+
+#include <stdio.h>
+
+#include "ad_solver.h"
+
+#define Min(x, y)  (((x) < (y)) ? (x) : (y))
+#define Max(x, y)  (((x) > (y)) ? (x) : (y))
+
+int
+Cost_If_Cycle(int current_cost, int i, int j, int k)
+{
+  int x;
+  int r;
+
+  r = Cost_If_Swap(current_cost, Min(i, j), Max(i, j));
+
+  x = ad_sol[i];
+  ad_sol[i] = ad_sol[j];
+  ad_sol[j] = x;
+  Executed_Swap(Min(i, j), Max(i, j));
+
+  r = Cost_If_Swap(r, Min(i, k), Max(i, k));
+
+  x = ad_sol[i];
+  ad_sol[i] = ad_sol[j];
+  ad_sol[j] = x;
+  Executed_Swap(Min(i, j), Max(i, j));
+
+  return r;
+}
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_cost_cycle_fct = 1;
+}
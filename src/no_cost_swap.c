@@ -9,6 +9,7 @@
 #include <stdio.h>
 
 #include "ad_solver.h"
+#include "prof.h"
 
 int
 Cost_If_Swap(int current_cost, int i, int j)
@@ -20,15 +21,25 @@ Cost_If_Swap(int current_cost, int i, int j)
   ad_sol[i] = ad_sol[j];
   ad_sol[j] = x;
 
-  r = Cost_Of_Solution(0);
+  r = Prof_Call(PROF_COST_OF_SOL_SWAP, Cost_Of_Solution(0));
 
   ad_sol[j] = ad_sol[i];
   ad_sol[i] = x;
 
   if (ad_reinit_after_if_swap)
-    Cost_Of_Solution(0);
+    Prof_Call_Void(PROF_COST_OF_SOL_SWAP, Cost_Of_Solution(0));
 
   return r;
 }
 
 
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_cost_swap_fct = 1;
+}
+
+
@@ -13,3 +13,13 @@ Executed_Swap(int k1, int k2)
 {
   //  ad.total_cost = Cost_Of_Solution(1);
 }
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_exec_swap_fct = 1;
+}
@@ -0,0 +1,27 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  no_footprint.c: wrapper when user function Swap_Footprint is not defined
+ */
+
+#include <stdio.h>
+
+#include "ad_solver.h"
+
+int
+Swap_Footprint(int i, int j, int *cstr)
+{
+  return -1;
+}
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_footprint_fct = 1;
+}
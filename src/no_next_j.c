@@ -6,6 +6,7 @@
  *  no_next_j.c: wrapper when user function Next_J is not defined
  */
 
+#include "ad_solver.h"
 
 int 
 Next_J(int i, int j)
@@ -14,3 +15,13 @@ Next_J(int i, int j)
     j = i;
   return j + 1;
 }
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_next_j_fct = 1;
+}
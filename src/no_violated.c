@@ -0,0 +1,27 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  no_violated.c: wrapper when user function Violated_Constraints is not defined
+ */
+
+#include <stdio.h>
+
+#include "ad_solver.h"
+
+int
+Violated_Constraints(int *cstr)
+{
+  return 0;
+}
+
+
+static void
+Init(void) __attribute__ ((constructor));
+
+static void
+Init(void)
+{
+  ad_no_violated_fct = 1;
+}
@@ -0,0 +1,130 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  prof.h: call counters and cycle timers (compile with -DPROF=1)
+ *
+ *  Each counter records the nb of calls and the nb of cycles (TSC on x86,
+ *  else nanoseconds of clock_gettime) spent in a user function or in a
+ *  phase of the engine. Without PROF all macros expand to nothing (or to
+ *  the bare call) so the instrumentation costs nothing.
+ */
+
+#ifndef PROF_H
+#define PROF_H 1
+
+#if defined(PROF) && PROF
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+enum
+{
+  PROF_COST_OF_SOL,		/* Cost_Of_Solution (init / restart) */
+  PROF_COST_OF_SOL_RESET,	/* Cost_Of_Solution called by Reset */
+  PROF_COST_OF_SOL_SWAP,	/* Cost_Of_Solution called by no_cost_swap.c */
+  PROF_COST_ON_VAR,		/* Cost_On_Variable */
+  PROF_COST_IF_SWAP,		/* Cost_If_Swap */
+  PROF_EXEC_SWAP,		/* Executed_Swap */
+  PROF_NEXT_I,			/* Next_I */
+  PROF_NEXT_J,			/* Next_J */
+  PROF_SELECT_HIGH_COST,	/* engine: Select_Var_High_Cost (incl. Cost_On_Variable) */
+  PROF_SELECT_MIN_CONFLICT,	/* engine: Select_Var_Min_Conflict (incl. Cost_If_Swap) */
+  PROF_SELECT_PAIR,		/* engine: Select_Vars_To_Swap (incl. Cost_If_Swap, Next_I/J) */
+  PROF_RESET,			/* engine: Reset (incl. Cost_Of_Solution) */
+  PROF_SOLVE,			/* engine: Ad_Solve (everything) */
+  PROF_NB
+};
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef unsigned long long ProfTime;
+
+typedef struct
+{
+  long long nb_call;		/* nb of calls */
+  ProfTime time;		/* nb of cycles */
+}ProfCounter;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+ProfCounter ad_prof[PROF_NB];	/* cumulated over all calls to Ad_Solve */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+void Ad_Prof_Display(void);
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define PROF_UNIT "TSC cycles"
+#define Prof_Clock()  ((ProfTime) __rdtsc())
+
+#else
+
+#define PROF_UNIT "nanoseconds"
+
+static inline ProfTime
+Prof_Clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ProfTime) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif
+
+
+#define Prof_Start(t0)       ProfTime t0 = Prof_Clock()
+
+#define Prof_End(k, t0)						\
+  do {								\
+    ad_prof[k].nb_call++;					\
+    ad_prof[k].time += Prof_Clock() - (t0);			\
+  } while(0)
+
+				/* call returning a value (gcc statement expr) */
+#define Prof_Call(k, call)					\
+  ({								\
+    ProfTime prof_t0 = Prof_Clock();				\
+    __typeof__(call) prof_r = (call);				\
+    Prof_End(k, prof_t0);					\
+    prof_r;							\
+  })
+
+#define Prof_Call_Void(k, call)					\
+  do {								\
+    ProfTime prof_t0 = Prof_Clock();				\
+    call;							\
+    Prof_End(k, prof_t0);					\
+  } while(0)
+
+#else  /* !PROF */
+
+#define Ad_Prof_Display()        ((void) 0)
+#define Prof_Start(t0)
+#define Prof_End(k, t0)
+#define Prof_Call(k, call)       (call)
+#define Prof_Call_Void(k, call)  call
+
+#endif /* !PROF */
+
+#endif /* !PROF_H */
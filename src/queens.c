@@ -306,6 +306,34 @@ Executed_Swap(int i1, int i2)
 
 
 
+/*
+ *  SWAP_FOOTPRINT
+ *
+ *  The diagonals changed by swapping the queens of lines i1 and i2
+ *  (diagonals 2 are numbered after the diagonals 1).
+ */
+
+int
+Swap_Footprint(int i1, int i2, int *cstr)
+{
+  int j1 = sol[i1];
+  int j2 = sol[i2];
+
+  cstr[0] = D1(i1, j1);
+  cstr[1] = D1(i2, j2);
+  cstr[2] = D1(i1, j2);
+  cstr[3] = D1(i2, j1);
+  cstr[4] = nb_diag + D2(i1, j1);
+  cstr[5] = nb_diag + D2(i2, j2);
+  cstr[6] = nb_diag + D2(i1, j2);
+  cstr[7] = nb_diag + D2(i2, j1);
+
+  return 8;
+}
+
+
+
+
 int param_needed = 1;		/* overwrite var of main.c */
 
 /*
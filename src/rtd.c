@@ -0,0 +1,355 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  rtd.c: runtime distribution and multi-walk speedup prediction
+ *
+ *  Reads the times of single-walker runs (one per line), fits a shifted
+ *  exponential and a lognormal distribution and predicts the time of an
+ *  independent multi-walk with k walkers, i.e. the expected minimum of k
+ *  draws: E[min_k] = integral of (1 - F(t))^k dt. The empirical prediction
+ *  uses the order statistics of the sample (draws with replacement).
+ *
+ *  Usage: rtd [-k LIST] [-S KEY] [FILE]
+ *    -k LIST  nb of walkers (default: 1 2 4 8 12 16 32 64)
+ *    -S KEY   output SQL INSERTs for the rtd_fit and predicted tables,
+ *             KEY gives the first columns, e.g. 'version','flags','bench',30
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define MAX_K                64	/* max nb of values for -k */
+
+#define NB_STEP              4000 /* steps of the numerical integration */
+
+#define MIN_TIME             0.0005 /* times are rounded (0.00 happens) */
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static double *t;		/* sorted times */
+static int n;			/* nb of times */
+
+static double mean;		/* sample mean */
+static double x0, lambda;	/* shifted exponential */
+static double mu, sigma;	/* lognormal */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Read_Times(FILE *f);
+
+static void Fit(void);
+
+static double KS(double (*cdf)(double));
+
+static double Cdf_Exp(double x);
+
+static double Cdf_Lognormal(double x);
+
+static double Min_Exp(int k);
+
+static double Min_Lognormal(int k);
+
+static double Min_Empirical(int k);
+
+
+
+
+static int
+Cmp_Double(const void *x, const void *y)
+{
+  double a = *(double *) x, b = *(double *) y;
+
+  return (a < b) ? -1 : (a > b);
+}
+
+
+
+
+/*
+ *  MAIN
+ *
+ */
+int
+main(int argc, char *argv[])
+{
+  int k[MAX_K] = { 1, 2, 4, 8, 12, 16, 32, 64 };
+  int nb_k = 8;
+  char *key = NULL;
+  FILE *f = stdin;
+  double ks_exp, ks_logn, e_exp, e_logn, e_emp, m_logn;
+  char *p;
+  int i;
+
+  for(i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+	{
+	  p = argv[++i];
+	  for(nb_k = 0; *p && nb_k < MAX_K; )
+	    {
+	      k[nb_k] = strtol(p, &p, 10);
+	      if (k[nb_k] > 0)
+		nb_k++;
+	      while(*p == ',' || *p == ' ')
+		p++;
+	    }
+	}
+      else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+	key = argv[++i];
+      else if (argv[i][0] != '-' && f == stdin)
+	{
+	  if ((f = fopen(argv[i], "r")) == NULL)
+	    {
+	      perror(argv[i]);
+	      return 1;
+	    }
+	}
+      else
+	{
+	  fprintf(stderr, "Usage: %s [-k LIST] [-S KEY] [FILE]\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  Read_Times(f);
+  if (n < 2)
+    {
+      fprintf(stderr, "at least 2 times are needed\n");
+      return 1;
+    }
+
+  Fit();
+  ks_exp = KS(Cdf_Exp);
+  ks_logn = KS(Cdf_Lognormal);
+  m_logn = exp(mu + sigma * sigma / 2);
+
+  if (key)
+    printf("INSERT INTO rtd_fit VALUES(%s,%d,%g,%g,%g,%g,%g,%g,%g,'%s');\n",
+	   key, n, mean, x0, lambda, mu, sigma, ks_exp, ks_logn,
+	   (ks_exp <= ks_logn) ? "exp" : "lognormal");
+  else
+    {
+      printf("%d runs, mean: %g  min: %g  median: %g  max: %g\n",
+	     n, mean, t[0], t[n / 2], t[n - 1]);
+      printf("shifted exponential: x0 = %g  lambda = %g  (KS distance: %.3f)\n", x0, lambda, ks_exp);
+      printf("lognormal:           mu = %g  sigma = %g  (KS distance: %.3f)\n", mu, sigma, ks_logn);
+      printf("best fit: %s\n\n", (ks_exp <= ks_logn) ? "shifted exponential" : "lognormal");
+      printf("walkers |      exp  speedup | lognormal speedup | empirical speedup\n");
+    }
+
+  for(i = 0; i < nb_k; i++)
+    {
+      e_exp = Min_Exp(k[i]);
+      e_logn = Min_Lognormal(k[i]);
+      e_emp = Min_Empirical(k[i]);
+
+      if (key)
+	{
+	  printf("INSERT INTO predicted VALUES(%s,%d,'exp',%g,%g);\n", key, k[i], e_exp, mean / e_exp);
+	  printf("INSERT INTO predicted VALUES(%s,%d,'lognormal',%g,%g);\n", key, k[i], e_logn, m_logn / e_logn);
+	  printf("INSERT INTO predicted VALUES(%s,%d,'empirical',%g,%g);\n", key, k[i], e_emp, mean / e_emp);
+	}
+      else
+	printf("%7d | %8.3f %8.2f | %8.3f %8.2f | %8.3f %8.2f\n", k[i],
+	       e_exp, mean / e_exp, e_logn, m_logn / e_logn, e_emp, mean / e_emp);
+    }
+
+  return 0;
+}
+
+
+
+
+/*
+ *  READ_TIMES
+ *
+ *  Reads one time per line (other lines are ignored) and sorts them.
+ */
+static void
+Read_Times(FILE *f)
+{
+  char line[256];
+  int size = 0;
+  double x;
+
+  while(fgets(line, sizeof(line), f))
+    {
+      if (sscanf(line, "%lf", &x) != 1)
+	continue;
+
+      if (n == size)
+	{
+	  size = (size) ? 2 * size : 1024;
+	  if ((t = (double *) realloc(t, size * sizeof(double))) == NULL)
+	    {
+	      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+	      exit(1);
+	    }
+	}
+      t[n++] = (x > MIN_TIME) ? x : MIN_TIME;
+    }
+
+  qsort(t, n, sizeof(double), Cmp_Double);
+}
+
+
+
+
+/*
+ *  FIT
+ *
+ *  Shifted exponential: unbiased estimators x0 = (n min - mean) / (n - 1)
+ *  and 1 / lambda = mean - x0. Lognormal: mean and std dev of log(t).
+ */
+static void
+Fit(void)
+{
+  double s = 0, sl = 0, sl2 = 0;
+  int i;
+
+  for(i = 0; i < n; i++)
+    {
+      s += t[i];
+      sl += log(t[i]);
+    }
+  mean = s / n;
+  mu = sl / n;
+
+  for(i = 0; i < n; i++)
+    sl2 += (log(t[i]) - mu) * (log(t[i]) - mu);
+  sigma = sqrt(sl2 / (n - 1));
+  if (sigma <= 0)
+    sigma = 1e-6;
+
+  x0 = (n * t[0] - mean) / (n - 1);
+  if (x0 < 0)
+    x0 = 0;
+  if (x0 >= mean)		/* all times are equal */
+    x0 = mean * (1 - 1e-6);
+  lambda = 1 / (mean - x0);
+}
+
+
+
+
+/*
+ *  KS
+ *
+ *  Returns the Kolmogorov-Smirnov distance between the sample and cdf.
+ */
+static double
+KS(double (*cdf)(double))
+{
+  double d = 0, f, e;
+  int i;
+
+  for(i = 0; i < n; i++)
+    {
+      f = (*cdf)(t[i]);
+      e = fabs(f - (double) i / n);
+      if (e > d)
+	d = e;
+      e = fabs((double) (i + 1) / n - f);
+      if (e > d)
+	d = e;
+    }
+
+  return d;
+}
+
+
+
+
+static double
+Cdf_Exp(double x)
+{
+  return (x <= x0) ? 0 : 1 - exp(-lambda * (x - x0));
+}
+
+
+
+
+static double
+Cdf_Lognormal(double x)
+{
+  return 0.5 * erfc(-(log(x) - mu) / (sigma * M_SQRT2));
+}
+
+
+
+
+/*
+ *  MIN_EXP
+ *
+ *  The minimum of k shifted exponentials is shifted exponential (k lambda).
+ */
+static double
+Min_Exp(int k)
+{
+  return x0 + 1 / (k * lambda);
+}
+
+
+
+
+/*
+ *  MIN_LOGNORMAL
+ *
+ *  Integrates (1 - F(t))^k with t = exp(u) (Simpson) over mu +/- 12 sigma.
+ */
+static double
+Min_Lognormal(int k)
+{
+  double a = mu - 12 * sigma, b = mu + 12 * sigma;
+  double h = (b - a) / NB_STEP, u, y, s;
+  int i;
+
+  s = exp(a);			/* (1 - F)^k ~ 1 below a */
+  for(i = 0; i <= NB_STEP; i++)
+    {
+      u = a + i * h;
+      y = pow(0.5 * erfc((u - mu) / (sigma * M_SQRT2)), k) * exp(u) * h / 3;
+      s += (i == 0 || i == NB_STEP) ? y : (i % 2) ? 4 * y : 2 * y;
+    }
+
+  return s;
+}
+
+
+
+
+/*
+ *  MIN_EMPIRICAL
+ *
+ *  E[min of k draws] = sum t_i (P(min >= t_i) - P(min > t_i)) for sorted t.
+ */
+static double
+Min_Empirical(int k)
+{
+  double s = 0;
+  int i;
+
+  for(i = 0; i < n; i++)
+    s += t[i] * (pow((double) (n - i) / n, k) - pow((double) (n - i - 1) / n, k));
+
+  return s;
+}
@@ -0,0 +1,200 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  telemetry.c: live status of a running process (shared memory)
+ *
+ *  The block is created at the first run of the process (a worker forked
+ *  by multi.c creates its own) and removed at exit (or by Telemetry_Stop).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "telemetry.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static AdTelemetry *telemetry;	/* the shared block */
+static char shm_name[32];	/* TELEMETRY_PREFIX<pid> */
+
+static double time_start;	/* start of the run */
+static double time_prev;	/* previous update */
+static long long iter_prev;	/* nb_iter_tot at the previous update */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Telemetry_Remove(void);
+
+static double Clock_Secs(void);
+
+
+
+
+/*
+ *  TELEMETRY_START
+ *
+ *  Called at the start of a run. Creates the block if needed.
+ *  On error the status is simply not published.
+ */
+void
+Telemetry_Start(int size, int seed, int interval)
+{
+  int pid = getpid();
+  int fd;
+
+  if (telemetry == NULL || telemetry->pid != pid) /* first run or forked worker */
+    {
+      telemetry_on = 0;
+      sprintf(shm_name, "%s%d", TELEMETRY_PREFIX, pid);
+      if ((fd = shm_open(shm_name, O_CREAT | O_RDWR | O_TRUNC, 0644)) < 0)
+	{
+	  perror(shm_name);
+	  return;
+	}
+
+      if (ftruncate(fd, sizeof(AdTelemetry)) < 0 ||
+	  (telemetry = (AdTelemetry *) mmap(NULL, sizeof(AdTelemetry), PROT_READ | PROT_WRITE,
+					    MAP_SHARED, fd, 0)) == MAP_FAILED)
+	{
+	  perror(shm_name);
+	  telemetry = NULL;
+	  close(fd);
+	  shm_unlink(shm_name);
+	  return;
+	}
+      close(fd);
+
+      memset(telemetry, 0, sizeof(AdTelemetry));
+      strcpy(telemetry->magic, TELEMETRY_MAGIC);
+      telemetry->version = TELEMETRY_VERSION;
+      telemetry->pid = pid;
+      telemetry->state = TELE_IDLE;
+      atexit(Telemetry_Remove);
+    }
+
+  telemetry->size = size;
+  telemetry->interval = interval;
+
+  time_start = time_prev = Clock_Secs();
+  iter_prev = 0;
+
+  telemetry_countdown = interval;
+  telemetry_on = 1;
+}
+
+
+
+
+/*
+ *  TELEMETRY_PUBLISH
+ *
+ *  Copies the counters of v (except the header) into the shared block and
+ *  computes the elapsed time and the speed. Starts a new run if the state
+ *  of the block is not TELE_RUNNING.
+ */
+void
+Telemetry_Publish(AdTelemetry *v)
+{
+  double t = Clock_Secs();
+  unsigned seq = telemetry->seq;
+  int run = telemetry->run;
+
+  if (telemetry->state != TELE_RUNNING)
+    run++;
+
+  v->iter_per_sec = (t > time_prev) ? (v->nb_iter_tot - iter_prev) / (t - time_prev) : 0;
+  v->elapsed = t - time_start;
+  time_prev = t;
+  iter_prev = v->nb_iter_tot;
+
+  __atomic_store_n(&telemetry->seq, seq + 1, __ATOMIC_RELAXED); /* odd: being updated */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  telemetry->state = v->state;
+  telemetry->run = run;
+  telemetry->seed = v->seed;
+  telemetry->cost = v->cost;
+  telemetry->best_cost = v->best_cost;
+  telemetry->nb_restart = v->nb_restart;
+  telemetry->nb_iter = v->nb_iter;
+  telemetry->nb_iter_tot = v->nb_iter_tot;
+  telemetry->nb_reset = v->nb_reset;
+  telemetry->nb_local_min = v->nb_local_min;
+  telemetry->nb_marked = v->nb_marked;
+  telemetry->iter_per_sec = v->iter_per_sec;
+  telemetry->elapsed = v->elapsed;
+
+  __atomic_store_n(&telemetry->seq, seq + 2, __ATOMIC_RELEASE);
+
+  telemetry_countdown = telemetry->interval;
+}
+
+
+
+
+/*
+ *  TELEMETRY_STOP
+ *
+ *  Removes the block now (for processes not ending with exit()).
+ */
+void
+Telemetry_Stop(void)
+{
+  Telemetry_Remove();
+  if (telemetry != NULL)
+    munmap(telemetry, sizeof(AdTelemetry));
+  telemetry = NULL;
+  telemetry_on = 0;
+}
+
+
+
+
+/*
+ *  TELEMETRY_REMOVE
+ *
+ *  Called at exit (only by the process owning the block).
+ */
+static void
+Telemetry_Remove(void)
+{
+  if (telemetry != NULL && telemetry->pid == getpid())
+    shm_unlink(shm_name);
+}
+
+
+
+
+/*
+ *  CLOCK_SECS
+ *
+ */
+static double
+Clock_Secs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
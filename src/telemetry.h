@@ -0,0 +1,100 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  telemetry.h: live status of a running process (shared memory)
+ *
+ *  When stat_interval > 0 the engine publishes a small status block in the
+ *  POSIX shared memory object /adstat.<pid> every stat_interval iterations.
+ *  The writer is the solver, readers (adstat) use the sequence counter
+ *  (seqlock): it is odd while the block is being updated, a reader retries
+ *  if it was odd or has changed during its copy. A killed process leaves its
+ *  block, adstat removes the blocks of dead processes.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H 1
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define TELEMETRY_MAGIC      "ADSTAT"
+#define TELEMETRY_VERSION    1
+#define TELEMETRY_PREFIX     "/adstat."	/* + pid */
+
+				/* state */
+enum
+{
+  TELE_IDLE,			/* no run yet */
+  TELE_RUNNING,
+  TELE_SOLVED,			/* last run ended with cost 0 */
+  TELE_UNSOLVED,		/* last run ended without solution */
+  TELE_NB_STATE
+};
+
+#define TELE_STATE_NAMES  { "idle", "running", "solved", "unsolved" }
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef struct
+{
+  char magic[8];		/* TELEMETRY_MAGIC */
+  int version;			/* TELEMETRY_VERSION */
+  int pid;			/* process publishing this block */
+  int size;			/* nb of variables */
+  int interval;			/* nb of iters between 2 updates */
+
+  unsigned seq;			/* seqlock: odd while being updated */
+
+  int state;			/* TELE_... */
+  int run;			/* run no (1 per Ad_Solve, e.g. bench runs) */
+  int seed;			/* random seed of the run */
+  int cost;			/* current cost */
+  int best_cost;		/* best cost of the run (all restarts) */
+  int nb_restart;		/* nb of restarts */
+  int nb_iter;			/* iterations of the current restart */
+  long long nb_iter_tot;	/* iterations of the run */
+  int nb_reset;			/* nb of resets (all restarts) */
+  int nb_local_min;		/* nb of local mins (all restarts) */
+  int nb_marked;		/* nb of currently marked (frozen) variables */
+  double iter_per_sec;		/* since the previous update */
+  double elapsed;		/* secs since the start of the run */
+}AdTelemetry;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+#if !defined(CELL)
+
+int telemetry_on;		/* true if the status is published */
+int telemetry_countdown;	/* nb of iters before the next update */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+void Telemetry_Start(int size, int seed, int interval);
+
+void Telemetry_Publish(AdTelemetry *v);
+
+void Telemetry_Stop(void);
+
+
+#else  /* CELL */
+
+#define telemetry_on  0
+#define Telemetry_Start(size, seed, interval)
+#define Telemetry_Publish(v)
+#define Telemetry_Stop()
+
+#endif /* CELL */
+
+#endif /* !TELEMETRY_H */
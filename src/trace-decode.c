@@ -0,0 +1,168 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  trace-decode.c: decodes a binary search trace (see trace.h)
+ *
+ *  Usage: trace-decode [-c] [-e EVENT] FILE
+ *    -c        CSV output (event,iter,cost,v0,...,v5)
+ *    -e EVENT  only show EVENT records (iter, plateau, loc_min, reset,...)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static char *event_name[] = TR_EVENT_NAMES;
+static char *adapt_name[] = TR_ADAPT_NAMES;
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void Display_Text(TraceRec *r);
+
+
+
+
+/*
+ *  MAIN
+ *
+ */
+int
+main(int argc, char *argv[])
+{
+  TraceHeader h;
+  TraceRec r;
+  FILE *f;
+  int csv = 0, only = -1;
+  char *file_name = NULL;
+  int i;
+
+  for(i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-c") == 0)
+	csv = 1;
+      else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+	{
+	  i++;
+	  for(only = 0; only < TR_NB_EVENT && strcmp(argv[i], event_name[only]) != 0; only++)
+	    ;
+	  if (only == TR_NB_EVENT)
+	    {
+	      fprintf(stderr, "unknown event %s\n", argv[i]);
+	      return 1;
+	    }
+	}
+      else if (argv[i][0] != '-' && file_name == NULL)
+	file_name = argv[i];
+      else
+	{
+	  fprintf(stderr, "Usage: %s [-c] [-e EVENT] FILE\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  if (file_name == NULL)
+    {
+      fprintf(stderr, "Usage: %s [-c] [-e EVENT] FILE\n", argv[0]);
+      return 1;
+    }
+
+  if ((f = fopen(file_name, "rb")) == NULL)
+    {
+      perror(file_name);
+      return 1;
+    }
+
+  if (fread(&h, sizeof(h), 1, f) != 1 || strcmp(h.magic, TRACE_MAGIC) != 0 ||
+      h.version != TRACE_VERSION || h.rec_size != sizeof(TraceRec))
+    {
+      fprintf(stderr, "%s: not a trace file (or another version)\n", file_name);
+      return 1;
+    }
+
+  if (csv)
+    printf("event,iter,cost,v0,v1,v2,v3,v4,v5\n");
+  else
+    printf("trace of %d variables, seed: %d\n", h.size, h.seed);
+
+  while(fread(&r, sizeof(r), 1, f) == 1)
+    {
+      if ((unsigned) r.type >= TR_NB_EVENT || (only >= 0 && r.type != only))
+	continue;
+
+      if (csv)
+	printf("%s,%d,%d,%d,%d,%d,%d,%d,%d\n", event_name[r.type], r.iter, r.cost,
+	       r.v[0], r.v[1], r.v[2], r.v[3], r.v[4], r.v[5]);
+      else
+	Display_Text(&r);
+    }
+
+  fclose(f);
+  return 0;
+}
+
+
+
+
+/*
+ *  DISPLAY_TEXT
+ *
+ *  Displays a record (in the format of the former text log file).
+ */
+static void
+Display_Text(TraceRec *r)
+{
+  switch(r->type)
+    {
+    case TR_ITER:
+      printf("----- iter no: %d, cost: %d, nb marked: %d ---\n", r->iter, r->cost, r->v[5]);
+      printf("\tswap: %d/%d  nb max/min (or pairs): %d/%d  new cost: %d\n",
+	     r->v[1], r->v[2], r->v[3], r->v[4], r->v[0]);
+      break;
+
+    case TR_PLATEAU:
+      printf("\tend of plateau, length: %d\n", r->v[0]);
+      break;
+
+    case TR_LOC_MIN:
+      printf("\tlocal min on var %d, nb marked: %d\n", r->v[0], r->v[1]);
+      break;
+
+    case TR_RESET:
+      printf("\tTOO MANY FROZEN VARS (%d) - RESET %d vars\n", r->v[1], r->v[0]);
+      break;
+
+    case TR_RESTART:
+      printf("\tRESTART no %d after %d iters (best cost: %d)\n", r->v[0], r->iter, r->v[1]);
+      break;
+
+    case TR_ADAPT:
+      printf("\tADAPT (%s) iter: %d -> P: %d f: %d F: %d l: %d reset: %d\n",
+	     ((unsigned) r->v[0] < TR_ADAPT_NB_REASON) ? adapt_name[r->v[0]] : "?",
+	     r->iter, r->v[1], r->v[2], r->v[3], r->v[4], r->v[5]);
+      break;
+
+    case TR_END:
+      printf("end after %d iters, cost: %d, %d restarts\n", r->iter, r->cost, r->v[0]);
+      break;
+    }
+}
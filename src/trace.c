@@ -0,0 +1,173 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  trace.c: binary search trace (log file)
+ *
+ *  The solver (single producer) appends records at trace_head, the writer
+ *  thread (single consumer) saves the records from trace_tail. Each index
+ *  is only written by its owner and published with a release store, so no
+ *  lock is needed. The producer only waits if the buffer is full.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define WRITER_SLEEP_NS      200000 /* when the buffer is empty */
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+static FILE *f_trace;		/* the log file */
+static pthread_t writer;	/* the writer thread */
+static int writer_stop;		/* set to ask the writer to terminate */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+static void *Writer(void *arg);
+
+
+
+
+/*
+ *  TRACE_OPEN
+ *
+ *  Creates the log file and starts the writer thread.
+ *  Returns 0 on error (the trace is then not recorded).
+ */
+int
+Trace_Open(char *file_name, int size, int seed)
+{
+  TraceHeader h;
+
+  if ((f_trace = fopen(file_name, "wb")) == NULL)
+    {
+      perror(file_name);
+      return 0;
+    }
+
+  if (trace_buff == NULL &&
+      (trace_buff = (TraceRec *) malloc(TRACE_BUFF_SIZE * sizeof(TraceRec))) == NULL)
+    {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(1);
+    }
+
+  memset(&h, 0, sizeof(h));
+  strcpy(h.magic, TRACE_MAGIC);
+  h.version = TRACE_VERSION;
+  h.rec_size = sizeof(TraceRec);
+  h.size = size;
+  h.seed = seed;
+  fwrite(&h, sizeof(h), 1, f_trace);
+
+  trace_head = trace_tail = 0;
+  trace_nb_stall = 0;
+  writer_stop = 0;
+
+  if (pthread_create(&writer, NULL, Writer, NULL) != 0)
+    {
+      perror("Trace_Open: pthread_create");
+      fclose(f_trace);
+      return 0;
+    }
+
+  trace_on = 1;
+  return 1;
+}
+
+
+
+
+/*
+ *  TRACE_CLOSE
+ *
+ *  Waits until all records are saved and closes the log file.
+ */
+void
+Trace_Close(void)
+{
+  if (!trace_on)
+    return;
+
+  trace_on = 0;
+  __atomic_store_n(&writer_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(writer, NULL);
+  fclose(f_trace);
+}
+
+
+
+
+/*
+ *  TRACE_WAIT
+ *
+ *  Called by the producer when the buffer is full.
+ */
+void
+Trace_Wait(void)
+{
+  trace_nb_stall++;
+  sched_yield();
+}
+
+
+
+
+/*
+ *  WRITER
+ *
+ *  The writer thread: saves the available records (the contiguous part of
+ *  the ring) then frees them. Terminates when asked and all is saved.
+ */
+static void *
+Writer(void *arg)
+{
+  struct timespec ts = { 0, WRITER_SLEEP_NS };
+  unsigned head, tail = trace_tail, i, n;
+
+  for(;;)
+    {
+      head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+      if (head == tail)
+	{
+	  if (__atomic_load_n(&writer_stop, __ATOMIC_ACQUIRE) &&
+	      __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE) == tail)
+	    break;
+	  nanosleep(&ts, NULL);
+	  continue;
+	}
+
+      i = tail & (TRACE_BUFF_SIZE - 1);
+      n = head - tail;
+      if (n > TRACE_BUFF_SIZE - i)
+	n = TRACE_BUFF_SIZE - i;
+
+      fwrite(trace_buff + i, sizeof(TraceRec), n, f_trace);
+      tail += n;
+      __atomic_store_n(&trace_tail, tail, __ATOMIC_RELEASE);
+    }
+
+  return NULL;
+}
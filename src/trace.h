@@ -0,0 +1,141 @@
+/*
+ *  Adaptive search
+ *
+ *  Copyright (C) 2002-2010 Daniel Diaz, Philippe Codognet and Salvador Abreu
+ *
+ *  trace.h: binary search trace (log file)
+ *
+ *  The engine puts fixed-size records in a single-producer/single-consumer
+ *  lock-free ring buffer, a writer thread drains it to the log file.
+ *  Use trace-decode to obtain a text or CSV version of the file.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H 1
+
+/*-----------*
+ * Constants *
+ *-----------*/
+
+#define TRACE_MAGIC          "ADTRACE"
+#define TRACE_VERSION        1
+
+#ifndef TRACE_BUFF_SIZE
+#define TRACE_BUFF_SIZE      (1 << 16) /* nb of records (power of 2) */
+#endif
+
+				/* event types (meaning of v[]) */
+enum
+{
+  TR_ITER,			/* new_cost, max_i, min_j, nb max (or pairs), nb min, nb marked */
+  TR_PLATEAU,			/* end of plateau: length */
+  TR_LOC_MIN,			/* local min: var, nb marked */
+  TR_RESET,			/* reset: nb vars to reset, nb marked */
+  TR_RESTART,			/* restart: restart no, best cost */
+  TR_ADAPT,			/* adaptation: reason, P, f, F, l, nb vars to reset */
+  TR_END,			/* end of resolution: nb restarts */
+  TR_NB_EVENT
+};
+
+#define TR_EVENT_NAMES \
+  { "iter", "plateau", "loc_min", "reset", "restart", "adapt", "end" }
+
+				/* reasons of TR_ADAPT */
+enum
+{
+  TR_ADAPT_IMPROVED,
+  TR_ADAPT_STAG_RESET,
+  TR_ADAPT_STAG_LOC_MIN,
+  TR_ADAPT_STAG_PLATEAU,
+  TR_ADAPT_STAG,
+  TR_ADAPT_NB_REASON
+};
+
+#define TR_ADAPT_NAMES							\
+  { "improved", "stagnation with resets", "stagnation in local mins",	\
+    "stagnation on plateaus", "stagnation" }
+
+
+/*-------*
+ * Types *
+ *-------*/
+
+typedef struct
+{
+  char magic[8];		/* TRACE_MAGIC */
+  int version;			/* TRACE_VERSION */
+  int rec_size;			/* sizeof(TraceRec) */
+  int size;			/* nb of variables */
+  int seed;			/* random seed */
+}TraceHeader;
+
+
+typedef struct
+{
+  int type;			/* event (TR_...) */
+  int iter;			/* iteration no (of the current restart) */
+  int cost;			/* current total cost */
+  int v[6];			/* event values (see above) */
+}TraceRec;
+
+
+/*------------------*
+ * Global variables *
+ *------------------*/
+
+#if !defined(CELL)
+
+int trace_on;			/* true if a trace is being recorded */
+TraceRec *trace_buff;		/* the ring buffer */
+unsigned trace_head;		/* next record to write (producer) */
+unsigned trace_tail;		/* next record to save (writer thread) */
+long long trace_nb_stall;	/* nb of times the producer waited (buffer full) */
+
+
+/*------------*
+ * Prototypes *
+ *------------*/
+
+int Trace_Open(char *file_name, int size, int seed);
+
+void Trace_Close(void);
+
+void Trace_Wait(void);
+
+
+
+/*
+ *  TRACE_EVENT
+ *
+ *  Records an event (cheap when no trace is recorded).
+ */
+#define Trace_Event(t, it, c, v0, v1, v2, v3, v4, v5)			\
+  do if (__builtin_expect(trace_on, 0))					\
+    {									\
+      TraceRec *trace_r;						\
+      while(trace_head - __atomic_load_n(&trace_tail, __ATOMIC_ACQUIRE) \
+	    >= TRACE_BUFF_SIZE)						\
+	Trace_Wait();							\
+      trace_r = trace_buff + (trace_head & (TRACE_BUFF_SIZE - 1));	\
+      trace_r->type = (t);						\
+      trace_r->iter = (it);						\
+      trace_r->cost = (c);						\
+      trace_r->v[0] = (v0);						\
+      trace_r->v[1] = (v1);						\
+      trace_r->v[2] = (v2);						\
+      trace_r->v[3] = (v3);						\
+      trace_r->v[4] = (v4);						\
+      trace_r->v[5] = (v5);						\
+      __atomic_store_n(&trace_head, trace_head + 1, __ATOMIC_RELEASE);	\
+    }									\
+  while(0)
+
+#else  /* CELL */
+
+#define Trace_Open(file_name, size, seed)  0
+#define Trace_Close()
+#define Trace_Event(t, it, c, v0, v1, v2, v3, v4, v5)
+
+#endif /* CELL */
+
+#endif /* !TRACE_H */